@@ -1,5 +1,4 @@
 DEPENDENCIES += tp_math_utils
-DEPENDENCIES += lib_base64
 INCLUDEPATHS += tp_image_utils/inc/
 LIBRARIES    += tp_image_utils
 DEFINES      += OS3_IO_LIBRARY
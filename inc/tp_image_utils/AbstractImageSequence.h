@@ -3,6 +3,8 @@
 
 #include "tp_image_utils/Globals.h"
 
+#include <functional>
+
 namespace tp_image_utils
 {
 class ColorMap;
@@ -18,6 +20,48 @@ public:
   virtual tp_image_utils::ColorMap loadImage(size_t i)=0;
 
   //################################################################################################
+  //! Load frames first, first+stride, ... up to but not including last.
+  /*!
+  The default implementation calls loadImage for each frame. Sequences where frames depend on each
+  other should override this to decode each group of pictures once and emit all the requested
+  frames from it.
+
+  Loading stops early if a frame fails to load or imageLoaded returns false.
+
+  \param first - The first frame to load.
+  \param last - One past the last frame to load.
+  \param stride - The distance between frames, values less than 1 are treated as 1.
+  \param imageLoaded - Called with the index and image of each frame in order.
+  */
+  virtual void loadImages(size_t first,
+                          size_t last,
+                          size_t stride,
+                          const std::function<bool(size_t i, const tp_image_utils::ColorMap& image)>& imageLoaded);
+
+  //################################################################################################
+  //! The number of frames in the sequence, or 0 if that is not known without decoding it.
+  virtual size_t frameCount();
+
+  //################################################################################################
+  //! The size of the frames in the sequence.
+  /*!
+  The default implementation decodes the first frame, sequences should override this if they can
+  get the size from a header.
+
+  \return false if the size could not be found.
+  */
+  virtual bool frameSize(size_t& width, size_t& height);
+
+  //################################################################################################
+  //! The frames that can be decoded without reference to others, in ascending order.
+  /*!
+  An empty list means that every frame can be decoded independently, as is the case for the
+  default implementation.
+  */
+  virtual std::vector<size_t> keyframeIndices();
+
+  //################################################################################################
+  //! Try each factory in turn, if none accept data it is opened as an ImageDirectorySequence.
   static AbstractImageSequence* loadSequence(const std::string& data);
 
   //################################################################################################
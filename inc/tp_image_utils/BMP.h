@@ -0,0 +1,25 @@
+#ifndef tp_image_utils_BMP_h
+#define tp_image_utils_BMP_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/RowSink.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Encode a 24 bit BGR or 32 bit BGRA uncompressed BMP.
+std::string saveBMPToData(const ColorMap& image, bool alpha=true);
+
+//##################################################################################################
+//! Decode an uncompressed 24 or 32 bit BMP, rows are written straight into the result.
+ColorMap loadBMPFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode a BMP one row at a time into sink, bottom up images are still passed top down.
+bool loadBMPRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors);
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef tp_image_utils_Base64_h
+#define tp_image_utils_Base64_h
+
+#include "tp_image_utils/Globals.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! The number of characters base64Encode writes for size bytes, including padding.
+size_t base64EncodedSize(size_t size);
+
+//##################################################################################################
+//! Encode size bytes into dst, which must have room for base64EncodedSize(size) characters.
+/*!
+Uses SSSE3 on x86 CPUs that support it, otherwise a table driven scalar encoder.
+*/
+void base64Encode(const uint8_t* src, size_t size, char* dst);
+
+//##################################################################################################
+//! The number of bytes that size characters of base64 decode to, taking padding into account.
+size_t base64DecodedSize(const char* src, size_t size);
+
+//##################################################################################################
+//! Decode base64 into dst, which must have room for base64DecodedSize(src, size) bytes.
+/*!
+Padding is optional, whitespace and other characters outside the base64 alphabet are rejected.
+
+\return false if the input contains invalid characters.
+*/
+bool base64Decode(const char* src, size_t size, uint8_t* dst);
+
+}
+
+#endif
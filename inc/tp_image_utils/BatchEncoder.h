@@ -0,0 +1,64 @@
+#ifndef tp_image_utils_BatchEncoder_h
+#define tp_image_utils_BatchEncoder_h
+
+#include "tp_image_utils/ColorMap.h"
+
+#include <vector>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+enum class EncodeFormat
+{
+  JPEG,
+  WebP
+};
+
+//##################################################################################################
+//! Encode many images concurrently on a bounded pool of threads.
+/*!
+Each thread keeps its EncoderContext alive between calls so the codec is only set up once, and the
+output strings are reused so their allocations carry over from one batch to the next. encode() can
+be called from several threads at the same time.
+*/
+class TP_IMAGE_UTILS_EXPORT BatchEncoder
+{
+  TP_NONCOPYABLE(BatchEncoder);
+public:
+  //################################################################################################
+  //! If nThreads is 0 the hardware concurrency will be used.
+  BatchEncoder(size_t nThreads=0);
+
+  //################################################################################################
+  ~BatchEncoder();
+
+  //################################################################################################
+  //! A shared encoder for general use.
+  static BatchEncoder& instance();
+
+  //################################################################################################
+  //! Encode count images into outputs, which is resized to count.
+  /*!
+  \param images - The images to encode.
+  \param count - The number of images.
+  \param format - JPEG or WebP, uses the buffer or data hooks for that format.
+  \param quality - Passed to the encoder.
+  \param outputs - The encoded images, strings from a previous call are reused. Images that fail
+  to encode produce an empty string.
+  \return true if all images were encoded.
+  */
+  bool encode(const ColorMap* images, size_t count, EncodeFormat format, int quality, std::vector<std::string>& outputs);
+
+  //################################################################################################
+  bool encode(const std::vector<ColorMap>& images, EncodeFormat format, int quality, std::vector<std::string>& outputs);
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define tp_image_utils_ByteMap_h
 
 #include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ContentHash.h"
 
 #include <vector>
 
@@ -72,6 +73,17 @@ public:
   //################################################################################################
   void setColumn(size_t x, const std::vector<uint8_t>& values);
 
+  //################################################################################################
+  //! A hash of the size and pixels.
+  [[nodiscard]] uint64_t contentHash() const;
+
+  //################################################################################################
+  [[nodiscard]] Hash128 contentHash128() const;
+
+  //################################################################################################
+  //! Returns true if the images are the same size and have identical pixels.
+  [[nodiscard]] bool contentEquals(const ByteMap& other) const;
+
 private:
   std::vector<uint8_t> m_data;
   size_t m_width;
@@ -2,11 +2,13 @@
 #define tp_image_utils_ColorMap_h
 
 #include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ContentHash.h"
 
 #include "tp_utils/TPPixel.h"
 #include "tp_utils/RefCount.h"
 
 #include <vector>
+#include <memory>
 
 namespace tp_image_utils
 {
@@ -19,17 +21,30 @@ public:
   //################################################################################################
   ColorMap(const ColorMap& other);
 
+  //################################################################################################
+  //! Take the data from other, leaving it as an empty image without allocating.
+  ColorMap(ColorMap&& other) noexcept;
+
   //################################################################################################
   ColorMap(size_t w=0, size_t h=0, const TPPixel* data=nullptr, const TPPixel& fill=TPPixel());
 
   //################################################################################################
   ~ColorMap();
 
+  //################################################################################################
+  //! Wrap external pixel data without copying it.
+  /*!
+  The data is treated as read only and owner is kept alive for as long as it is referenced. The first
+  call that modifies the image copies the data into a new buffer. The fractional size is set here
+  because setFractionalSize() would detach and copy the data.
+  */
+  [[nodiscard]] static ColorMap wrapReadOnly(size_t w, size_t h, const TPPixel* data, const std::shared_ptr<const void>& owner, float fw=1.0f, float fh=1.0f);
+
   //################################################################################################
   ColorMap& operator=(const ColorMap& other);
 
   //################################################################################################
-  ColorMap& operator=(ColorMap&& other);
+  ColorMap& operator=(ColorMap&& other) noexcept;
 
   //################################################################################################
   void fill(TPPixel value);
@@ -130,6 +145,25 @@ public:
   //################################################################################################
   bool sameObject(const ColorMap& other) const;
 
+  //################################################################################################
+  //! Returns true if other ColorMaps reference the same data, empty images are always shared.
+  [[nodiscard]] bool isShared() const;
+
+  //################################################################################################
+  //! A hash of the size and pixels, cached until the image is next modified.
+  /*!
+  The cache is cleared by the calls that detach the image such as data() and pixelRef(), so pixels
+  must not be written through pointers or references obtained before the hash was calculated.
+  */
+  [[nodiscard]] uint64_t contentHash() const;
+
+  //################################################################################################
+  [[nodiscard]] Hash128 contentHash128() const;
+
+  //################################################################################################
+  //! Returns true if the images are the same size and have identical pixels.
+  [[nodiscard]] bool contentEquals(const ColorMap& other) const;
+
 private:
   struct SD;
   friend struct SD;
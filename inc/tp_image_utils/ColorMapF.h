@@ -2,6 +2,7 @@
 #define tp_image_utils_ColorMapF_h
 
 #include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ContentHash.h"
 
 
 #include "tp_utils/RefCount.h"
@@ -9,6 +10,7 @@
 #include "glm/glm.hpp"
 
 #include <vector>
+#include <memory>
 #include <stdint.h>
 
 namespace tp_image_utils
@@ -22,17 +24,30 @@ public:
   //################################################################################################
   ColorMapF(const ColorMapF& other);
 
+  //################################################################################################
+  //! Take the data from other, leaving it as an empty image without allocating.
+  ColorMapF(ColorMapF&& other) noexcept;
+
   //################################################################################################
   ColorMapF(size_t w=0, size_t h=0, const glm::vec4* data=nullptr, const glm::vec4& fill=glm::vec4(0,0,0,1));
 
   //################################################################################################
   ~ColorMapF();
 
+  //################################################################################################
+  //! Wrap external pixel data without copying it.
+  /*!
+  The data is treated as read only and owner is kept alive for as long as it is referenced. The first
+  call that modifies the image copies the data into a new buffer. The fractional size is set here
+  because setFractionalSize() would detach and copy the data.
+  */
+  [[nodiscard]] static ColorMapF wrapReadOnly(size_t w, size_t h, const glm::vec4* data, const std::shared_ptr<const void>& owner, float fw=1.0f, float fh=1.0f);
+
   //################################################################################################
   ColorMapF& operator=(const ColorMapF& other);
 
   //################################################################################################
-  ColorMapF& operator=(ColorMapF&& other);
+  ColorMapF& operator=(ColorMapF&& other) noexcept;
 
   //################################################################################################
   void fill(const glm::vec4& value);
@@ -126,6 +141,21 @@ public:
   */
   [[nodiscard]]float fh() const;
 
+  //################################################################################################
+  //! A hash of the size and pixels, cached until the image is next modified.
+  /*!
+  The cache is cleared by the calls that detach the image such as data() and pixelRef(), so pixels
+  must not be written through pointers or references obtained before the hash was calculated.
+  */
+  [[nodiscard]] uint64_t contentHash() const;
+
+  //################################################################################################
+  [[nodiscard]] Hash128 contentHash128() const;
+
+  //################################################################################################
+  //! Returns true if the images are the same size and have identical pixels, compared bitwise.
+  [[nodiscard]] bool contentEquals(const ColorMapF& other) const;
+
 private:
   struct SD;
   friend struct SD;
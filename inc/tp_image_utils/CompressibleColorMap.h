@@ -0,0 +1,95 @@
+#ifndef tp_image_utils_CompressibleColorMap_h
+#define tp_image_utils_CompressibleColorMap_h
+
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct CompressibleColorMapStats
+{
+  size_t budget{0};           //!< The limit on residentBytes.
+  size_t residentBytes{0};    //!< Uncompressed pixels held by all holders.
+  size_t compressedBytes{0};  //!< Compressed copies held by all holders.
+  size_t holders{0};          //!< The number of CompressibleColorMap objects.
+  size_t compressions{0};     //!< Images that have been compressed.
+  size_t decompressions{0};   //!< Images that have been decompressed on access.
+};
+
+//##################################################################################################
+//! Holds an image that is compressed when it has not been used recently.
+/*!
+All holders share a global budget for uncompressed pixels, when it is exceeded the least recently
+used images are compressed with QOI, which is lossless and fast to decode. The image is decompressed
+again on the next call to image(), constData(), or data().
+
+Images that are also referenced by a ColorMap outside the holder are never compressed since that
+would not free any memory, so holding the ColorMap returned by image() keeps the pixels resident.
+The pointers returned by constData() and data() are only valid while the image is resident. The
+image can be compressed by the construction of, or setImage() on, any holder, or by setBudget() and
+compressIdle(), even on the same thread. Hold the ColorMap returned by image() instead to keep the
+pixels valid.
+
+The compressed copy is kept after decompression so that compressing an unmodified image again is
+free, calling data() discards it.
+
+Holders are thread safe, the codec work is done under the lock of the global budget.
+*/
+class TP_IMAGE_UTILS_EXPORT CompressibleColorMap
+{
+  TP_NONCOPYABLE(CompressibleColorMap);
+public:
+  //################################################################################################
+  CompressibleColorMap(const ColorMap& image=ColorMap());
+
+  //################################################################################################
+  ~CompressibleColorMap();
+
+  //################################################################################################
+  void setImage(const ColorMap& image);
+
+  //################################################################################################
+  //! Returns the image, decompressing it if needed.
+  ColorMap image() const;
+
+  //################################################################################################
+  const TPPixel* constData() const;
+
+  //################################################################################################
+  TPPixel* data();
+
+  //################################################################################################
+  //! The size of the image, this does not decompress it.
+  size_t width() const;
+
+  //################################################################################################
+  size_t height() const;
+
+  //################################################################################################
+  bool isCompressed() const;
+
+  //################################################################################################
+  //! Compress the image now, unless it is referenced elsewhere.
+  void compress();
+
+  //################################################################################################
+  //! Set the number of bytes of uncompressed pixels that all holders can use, the default is 1GB.
+  static void setBudget(size_t bytes);
+
+  //################################################################################################
+  //! Compress all images that have not been accessed for the given number of seconds.
+  static void compressIdle(double seconds);
+
+  //################################################################################################
+  static CompressibleColorMapStats stats();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
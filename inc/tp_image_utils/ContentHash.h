@@ -0,0 +1,55 @@
+#ifndef tp_image_utils_ContentHash_h
+#define tp_image_utils_ContentHash_h
+
+#include "tp_image_utils/Globals.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct Hash128
+{
+  uint64_t low{0};
+  uint64_t high{0};
+
+  //################################################################################################
+  bool operator==(const Hash128& other) const
+  {
+    return low==other.low && high==other.high;
+  }
+
+  //################################################################################################
+  bool operator!=(const Hash128& other) const
+  {
+    return !(*this==other);
+  }
+};
+
+//##################################################################################################
+//! A fast non-cryptographic hash of a block of memory.
+/*!
+This follows the design of XXH3: 64 byte stripes are folded into eight 64 bit accumulators with
+32x32 bit multiplies against a key derived from the seed, using SSE2 where available. The
+accumulators are scrambled every 1KB and then mixed down with 64x64 bit multiplies. The results are
+stable across platforms but are not the same values as the reference XXH3 implementation.
+
+Images use this through their contentHash() methods, which also cover the width and height.
+*/
+Hash128 contentHash128(const void* data, size_t size, uint64_t seed=0);
+
+//##################################################################################################
+//! The low 64 bits of contentHash128.
+uint64_t contentHash64(const void* data, size_t size, uint64_t seed=0);
+
+//##################################################################################################
+//! Hash the pixels of an image, the seed includes the dimensions and type so that images with the
+//! same bytes but a different shape or pixel format do not collide.
+Hash128 imageContentHash128(const void* data, size_t width, size_t height, size_t bytesPerPixel);
+
+//##################################################################################################
+//! Compare two buffers, this is memcmp but named to make its use for image content clear.
+bool contentEquals(const void* a, const void* b, size_t size);
+
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef tp_image_utils_DeltaFrameStore_h
+#define tp_image_utils_DeltaFrameStore_h
+
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Holds a sequence of frames in memory as keyframes and compressed deltas.
+/*!
+Each frame that is not a keyframe is stored as the XOR of its pixels with the previous frame. The
+image is split into 16x16 tiles, runs of unchanged tiles are skipped with a single count, and
+within changed tiles runs of unchanged pixels are skipped in the same way, so footage from a static
+camera costs little more than its moving parts.
+
+A keyframe is stored every keyframeInterval frames, when the frame size changes, or when a delta
+would be larger than half of the uncompressed frame. Reading a frame applies at most
+keyframeInterval-1 deltas, and reading frames in order applies only one as the last frame read is
+kept.
+
+This class is thread safe.
+*/
+class TP_IMAGE_UTILS_EXPORT DeltaFrameStore
+{
+  TP_NONCOPYABLE(DeltaFrameStore);
+public:
+  //################################################################################################
+  DeltaFrameStore(size_t keyframeInterval=32);
+
+  //################################################################################################
+  ~DeltaFrameStore();
+
+  //################################################################################################
+  //! Add a frame to the end of the store and return its index.
+  size_t append(const ColorMap& image);
+
+  //################################################################################################
+  //! Returns frame i, or an empty image if i is out of range.
+  ColorMap frame(size_t i) const;
+
+  //################################################################################################
+  //! The number of frames in the store.
+  size_t size() const;
+
+  //################################################################################################
+  bool isKeyframe(size_t i) const;
+
+  //################################################################################################
+  //! The memory used by the stored frames.
+  size_t bytes() const;
+
+  //################################################################################################
+  //! The memory the frames would use if stored uncompressed.
+  size_t uncompressedBytes() const;
+
+  //################################################################################################
+  void clear();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
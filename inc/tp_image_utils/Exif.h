@@ -0,0 +1,68 @@
+#ifndef tp_image_utils_Exif_h
+#define tp_image_utils_Exif_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! The EXIF tags that affect how an image is displayed and when it was taken.
+struct ExifInfo
+{
+  //! How to transform the decoded image for display, using the values from the EXIF specification:
+  //! 1 none, 2 flip horizontal, 3 rotate 180, 4 flip vertical, 5 transpose, 6 rotate 90 CW,
+  //! 7 transverse, 8 rotate 90 CCW.
+  int orientation{1};
+
+  std::string dateTime;           //!< "YYYY:MM:DD HH:MM:SS" when the file was last changed.
+  std::string dateTimeOriginal;   //!< "YYYY:MM:DD HH:MM:SS" when the picture was taken.
+  std::string dateTimeDigitized;  //!< "YYYY:MM:DD HH:MM:SS" when the picture was stored.
+  std::string subSecTimeOriginal; //!< Fractional digits of the seconds in dateTimeOriginal.
+  std::string offsetTimeOriginal; //!< "+HH:MM" time zone of dateTimeOriginal, empty if unknown.
+
+  //################################################################################################
+  //! Milliseconds since the Unix epoch that the picture was taken.
+  /*!
+  Uses dateTimeOriginal, falling back to dateTime. If there is no time zone offset the time is
+  treated as UTC.
+
+  \return false if there is no valid time.
+  */
+  bool timestampMS(int64_t& ms) const;
+};
+
+//##################################################################################################
+//! Read the EXIF orientation and timestamps from the raw data of an image.
+/*!
+Only the header is examined: the APP1 segment of a JPEG, the eXIf chunk of a PNG, the EXIF chunk of
+a WebP, or IFD0 of a TIFF. No pixel data is read and nothing is allocated other than the strings.
+
+\return true if EXIF data was found.
+*/
+bool readExif(const uint8_t* data, size_t size, ExifInfo& info);
+
+//##################################################################################################
+bool readExif(const std::string& data, ExifInfo& info);
+
+//##################################################################################################
+//! Memory map a file and read its EXIF data, only the pages containing the header are read.
+bool readExifFromFile(const std::string& path, ExifInfo& info);
+
+//##################################################################################################
+//! Returns true if the orientation swaps the width and height.
+bool orientationSwapsAxes(int orientation);
+
+//##################################################################################################
+//! Transform an image from its stored orientation to the orientation it should be displayed in.
+/*!
+Rotations, flips, and transposes are all done in a single pass over the image, reading in tiles
+so that the transposing orientations stay cache friendly. An orientation of 1 or an unknown value
+returns the image without copying it.
+*/
+ColorMap applyOrientation(const ColorMap& image, int orientation);
+
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef tp_image_utils_FrameReader_h
+#define tp_image_utils_FrameReader_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+class AbstractImageSequence;
+
+//##################################################################################################
+struct FrameReaderStats
+{
+  size_t requests{0};     //!< Calls to FrameReader::frame().
+  size_t hits{0};         //!< Frames that were already decoded.
+  size_t waits{0};        //!< Frames that were being decoded ahead and had to be waited for.
+  size_t misses{0};       //!< Frames decoded on the calling thread.
+  size_t prefetched{0};   //!< Frames decoded ahead on the background threads.
+  size_t evictions{0};    //!< Frames removed to stay within the byte budget.
+  size_t bytes{0};        //!< The size of the frames currently held.
+  size_t count{0};        //!< The number of frames currently held.
+
+  double meanLatency{0.0}; //!< Mean time in seconds that frame() took over the recent requests.
+  double p95Latency{0.0};  //!< 95th percentile of recent requests.
+  double maxLatency{0.0};  //!< Slowest recent request.
+};
+
+//##################################################################################################
+//! Reads frames from a sequence, decoding ahead in the direction that frames are being accessed.
+/*!
+Forward, backward, and strided access are detected from the distance between consecutive requests,
+once the same distance has been seen twice the next lookAhead frames are decoded on background
+threads. Decoded frames are kept in an LRU cache bounded by maxBytes, which also serves scrubbing
+back and forth over recent frames.
+
+The sequence is not owned and must outlive the reader. Unless nThreads is 1 the sequence must
+support concurrent calls to loadImage, with 1 thread calls are serialized.
+*/
+class TP_IMAGE_UTILS_EXPORT FrameReader
+{
+  TP_NONCOPYABLE(FrameReader);
+public:
+  //################################################################################################
+  FrameReader(AbstractImageSequence* sequence, size_t maxBytes=536870912, size_t lookAhead=4, size_t nThreads=1);
+
+  //################################################################################################
+  //! Waits for any frames that are being decoded.
+  ~FrameReader();
+
+  //################################################################################################
+  //! Returns frame i, this may block if the frame has not been decoded yet.
+  ColorMap frame(size_t i);
+
+  //################################################################################################
+  //! The distance between frames that are being read ahead, 0 if the access pattern is random.
+  int64_t stride() const;
+
+  //################################################################################################
+  void setMaxBytes(size_t maxBytes);
+
+  //################################################################################################
+  //! Remove all cached frames.
+  void clear();
+
+  //################################################################################################
+  FrameReaderStats stats() const;
+
+  //################################################################################################
+  void resetStats();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
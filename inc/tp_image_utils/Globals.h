@@ -26,6 +26,10 @@ enum class FileType
   bmp,
   webp,
   ico,
+  qoi,
+  tga,
+  pnm,
+  pfm,
   ImagesEnd,
 
   VideosStart,
@@ -50,6 +54,10 @@ This tries to guess the image type from the image data, if that fails it will tr
 */
 FileType guessImageFormat(const std::string& data, const std::string& name);
 
+//##################################################################################################
+//! Same as above but avoids the need to copy data into a std::string.
+FileType guessImageFormat(const uint8_t* data, size_t size, const std::string& name);
+
 //##################################################################################################
 bool isVideo(FileType fileType);
 
@@ -0,0 +1,66 @@
+#ifndef tp_image_utils_HammingIndex_h
+#define tp_image_utils_HammingIndex_h
+
+#include "tp_image_utils/Globals.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct HammingMatch
+{
+  size_t id{0};     //!< The id returned by HammingIndex::add.
+  int distance{0};  //!< The number of bits that differ from the query.
+};
+
+//##################################################################################################
+//! Finds 64 bit hashes within a Hamming distance of a query, for perceptual hash deduplication.
+/*!
+This uses multi-index hashing: each hash is split into four 16 bit parts and each part indexes its
+own table. Any hash within distance r of the query must match at least one part to within r/4
+bits, so a query only visits the buckets that are within r/4 bits of the query parts and then
+checks the full distance of the hashes it finds there. Queries for up to 15 bits touch at most a
+few thousand buckets regardless of the number of hashes, larger distances scan every hash.
+
+Queries can be made from multiple threads but not while hashes are being added.
+*/
+class TP_IMAGE_UTILS_EXPORT HammingIndex
+{
+  TP_NONCOPYABLE(HammingIndex);
+public:
+  //################################################################################################
+  HammingIndex();
+
+  //################################################################################################
+  ~HammingIndex();
+
+  //################################################################################################
+  //! Add a hash and return its id, ids are allocated sequentially from 0.
+  size_t add(uint64_t hash);
+
+  //################################################################################################
+  void add(const std::vector<uint64_t>& hashes);
+
+  //################################################################################################
+  size_t size() const;
+
+  //################################################################################################
+  uint64_t hash(size_t id) const;
+
+  //################################################################################################
+  //! Find the hashes within maxDistance bits of hash, sorted by distance and then id.
+  std::vector<HammingMatch> find(uint64_t hash, int maxDistance) const;
+
+  //################################################################################################
+  //! Remove all hashes.
+  void clear();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef tp_image_utils_ImageCache_h
+#define tp_image_utils_ImageCache_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct ImageCacheStats
+{
+  size_t hits{0};      //!< Requests served from the cache, including ones that waited on a decode.
+  size_t misses{0};    //!< Requests that had to decode the image.
+  size_t evictions{0}; //!< Images removed to stay within the byte budget.
+  size_t bytes{0};     //!< The size of the images currently held.
+  size_t count{0};     //!< The number of images currently held.
+};
+
+//##################################################################################################
+//! A thread safe LRU cache of decoded images.
+/*!
+Images are keyed on the path, the file size and modification time, and the requested target size,
+so a file that changes on disk is decoded again. The returned images share their data with the
+cache so handing them out does not copy pixels.
+
+Concurrent requests for the same key that is not yet cached wait for a single decode rather than
+decoding the image several times.
+*/
+class TP_IMAGE_UTILS_EXPORT ImageCache
+{
+  TP_NONCOPYABLE(ImageCache);
+public:
+  //################################################################################################
+  ImageCache(size_t maxBytes=268435456);
+
+  //################################################################################################
+  ~ImageCache();
+
+  //################################################################################################
+  //! The process wide cache.
+  static ImageCache& instance();
+
+  //################################################################################################
+  //! Load an image through the cache, scaling to targetWidth x targetHeight if they are not 0.
+  ColorMap loadImage(const std::string& path, size_t targetWidth=0, size_t targetHeight=0);
+
+  //################################################################################################
+  ColorMap loadImage(const std::string& path,
+                     std::vector<std::string>& errors,
+                     size_t targetWidth=0,
+                     size_t targetHeight=0);
+
+  //################################################################################################
+  void setMaxBytes(size_t maxBytes);
+
+  //################################################################################################
+  size_t maxBytes() const;
+
+  //################################################################################################
+  //! Remove all cached images, decodes that are in progress are not affected.
+  void clear();
+
+  //################################################################################################
+  ImageCacheStats stats() const;
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
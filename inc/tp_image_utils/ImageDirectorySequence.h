@@ -0,0 +1,86 @@
+#ifndef tp_image_utils_ImageDirectorySequence_h
+#define tp_image_utils_ImageDirectorySequence_h
+
+#include "tp_image_utils/AbstractImageSequence.h"
+#include "tp_image_utils/ImageInfo.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! A sequence of frames stored as individual image files.
+/*!
+The frames are either all of the images in a directory, sorted so that embedded numbers compare by
+value (frame_2 before frame_10), or the files that match a printf style pattern such as
+"/path/frame_%05d.png" sorted by frame number. The files are listed with imagePaths().
+
+Frames are decoded from memory mapped files and loadImage can be called from multiple threads, so
+this can be used with a FrameReader with more than one thread. loadImages decodes ahead on a pool
+of worker threads while still passing the frames to the callback in order.
+*/
+class TP_IMAGE_UTILS_EXPORT ImageDirectorySequence : public AbstractImageSequence
+{
+  TP_NONCOPYABLE(ImageDirectorySequence);
+public:
+  //################################################################################################
+  //! Create a sequence from a list of paths, these are used in the order given.
+  /*!
+  \param paths - The image file for each frame.
+  \param nThreads - Threads used by loadImages, 0 uses the hardware concurrency.
+  */
+  ImageDirectorySequence(const std::vector<std::string>& paths, size_t nThreads=0);
+
+  //################################################################################################
+  ~ImageDirectorySequence() override;
+
+  //################################################################################################
+  //! Open a directory or numbered file pattern, returns nullptr if path is neither or is empty.
+  static ImageDirectorySequence* open(const std::string& path, size_t nThreads=0);
+
+  //################################################################################################
+  const std::vector<std::string>& paths() const;
+
+  //################################################################################################
+  tp_image_utils::ColorMap loadImage(size_t i) override;
+
+  //################################################################################################
+  void loadImages(size_t first,
+                  size_t last,
+                  size_t stride,
+                  const std::function<bool(size_t i, const tp_image_utils::ColorMap& image)>& imageLoaded) override;
+
+  //################################################################################################
+  size_t frameCount() override;
+
+  //################################################################################################
+  //! Reads the size of the first frame from its header without decoding it.
+  bool frameSize(size_t& width, size_t& height) override;
+
+  //################################################################################################
+  //! Read the header of frame i, the result is cached.
+  bool frameInfo(size_t i, ImageInfo& info);
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+//##################################################################################################
+//! Parse a printf style frame pattern such as "frame_%05d.png".
+/*!
+\param pattern - The file name to parse, this should not include the directory.
+\param prefix - Populated with the text before the number.
+\param suffix - Populated with the text after the number.
+\param width - Populated with the zero padded width of the number, 0 if it is not padded.
+\return True if pattern contains a single %d or %0Nd.
+*/
+bool parseFramePattern(const std::string& pattern, std::string& prefix, std::string& suffix, size_t& width);
+
+//##################################################################################################
+//! Compare strings so that runs of digits are ordered by their numeric value.
+bool naturalLess(const std::string& a, const std::string& b);
+
+}
+
+#endif
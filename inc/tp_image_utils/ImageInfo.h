@@ -0,0 +1,50 @@
+#ifndef tp_image_utils_ImageInfo_h
+#define tp_image_utils_ImageInfo_h
+
+#include "tp_image_utils/Globals.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Details about an image that can be read from its header without decoding it.
+struct ImageInfo
+{
+  FileType fileType{FileType::Unknown};
+  size_t width{0};
+  size_t height{0};
+  size_t channels{0}; //!< The number of color channels including alpha, palette images report 3.
+  size_t bitDepth{0}; //!< The number of bits per channel.
+};
+
+//##################################################################################################
+//! Read the type, size, and pixel format of an image from its header.
+/*!
+The file type is detected using guessImageFormat, then only the header structures needed to find
+the dimensions are parsed: the PNG IHDR, JPEG SOF markers, GIF screen descriptor, BMP info header,
+WebP VP8/VP8L/VP8X chunks, TIFF IFD, ICO directory, and the QOI, TGA and Netpbm headers.
+
+\param data - The image data, this can be truncated as long as it contains the header.
+\param info - Populated with the details of the image.
+\return True if the dimensions were found.
+*/
+bool imageInfo(const std::string& data, ImageInfo& info);
+
+//##################################################################################################
+bool imageInfo(const uint8_t* data, size_t size, ImageInfo& info);
+
+//##################################################################################################
+//! Read the type, size, and pixel format of an image file from its header.
+/*!
+Unlike loading the file this only reads the few blocks that contain the header, seeking over
+things like large JPEG EXIF segments and jumping directly to the TIFF IFD.
+
+\param path - The path of the image file.
+\param info - Populated with the details of the image.
+\return True if the dimensions were found.
+*/
+bool imageInfoFromFile(const std::string& path, ImageInfo& info);
+
+}
+
+#endif
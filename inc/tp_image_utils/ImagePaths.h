@@ -0,0 +1,43 @@
+#ifndef tp_image_utils_ImagePaths_h
+#define tp_image_utils_ImagePaths_h
+
+#include "tp_image_utils/Globals.h"
+
+#include <unordered_set>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct ImagePathsOptions
+{
+  bool recursive{false};      //!< Descend into sub directories.
+  bool followSymlinks{false}; //!< Descend into symlinked directories, each directory is listed once.
+  bool sniff{false};          //!< Read the first 16 bytes of each file and check its magic number.
+  size_t nThreads{0};         //!< Threads used to scan directories in parallel, 0 for hardware concurrency.
+};
+
+//##################################################################################################
+//! Find image files using the native directory functions.
+/*!
+Files are matched by extension against imageExtensionsSet(), ignoring case. On POSIX systems the
+type reported by readdir is used so files are only stat'ed when the file system doesn't report it,
+and file contents are only read when sniff is set. When recursive is set each directory is listed
+as a separate task on a pool of worker threads.
+
+\param directory - The directory to search.
+\param options - How to search.
+\param errors - Directories that could not be opened are reported here, the scan continues.
+\return Absolute paths to the image files sorted by name.
+*/
+std::vector<std::string> scanImagePaths(const std::string& directory,
+                                        const ImagePathsOptions& options,
+                                        std::vector<std::string>& errors);
+
+//##################################################################################################
+//! The lower case extensions of the image types, including the dot, for example ".jpg".
+const std::unordered_set<std::string>& imageExtensionsSet();
+
+}
+
+#endif
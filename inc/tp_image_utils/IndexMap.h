@@ -2,6 +2,7 @@
 #define tp_image_utils_IndexMap_h
 
 #include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ContentHash.h"
 
 #include <vector>
 
@@ -66,6 +67,17 @@ public:
   //! Simply sets the sise of the image, does NOT scale the contents
   void setSize(size_t width, size_t height);
 
+  //################################################################################################
+  //! A hash of the size and pixels.
+  [[nodiscard]] uint64_t contentHash() const;
+
+  //################################################################################################
+  [[nodiscard]] Hash128 contentHash128() const;
+
+  //################################################################################################
+  //! Returns true if the images are the same size and have identical pixels.
+  [[nodiscard]] bool contentEquals(const IndexMap& other) const;
+
 private:
   std::vector<uint32_t> m_data;
   size_t m_width;
@@ -5,11 +5,14 @@
 #include "tp_image_utils/ColorMap.h"
 #include "tp_image_utils/ColorMapF.h"
 #include "tp_image_utils/ByteMap.h"
+#include "tp_image_utils/RowSink.h"
+#include "tp_image_utils/LoadOptions.h"
 
 #include "json.hpp"
 
 #include <vector>
 #include <unordered_set>
+#include <functional>
 
 namespace tp_image_utils
 {
@@ -20,12 +23,47 @@ ColorMap loadImage(const std::string& path);
 //##################################################################################################
 ColorMap loadImage(const std::string& path, std::vector<std::string>& errors);
 
+//##################################################################################################
+//! Load an image at the size described by options.
+/*!
+The loadImageWithOptions_ hook is used if installed so that the decoder can reduce the resolution
+as it decodes, the result is then scaled to exactly options.width by options.height.
+*/
+ColorMap loadImage(const std::string& path, const LoadOptions& options, std::vector<std::string>& errors);
+
 //##################################################################################################
 ColorMap loadImageFromData(const std::string& data);
 
 //##################################################################################################
 ColorMap loadImageFromData(const std::string& data, std::vector<std::string>& errors);
 
+//##################################################################################################
+//! Decode an image from a buffer without copying it, useful for memory mapped files or network frames.
+ColorMap loadImageFromData(const uint8_t* data, size_t size);
+
+//##################################################################################################
+ColorMap loadImageFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode an image one row at a time into sink.
+/*!
+QOI, Netpbm and, when no other codec is installed, BMP images are streamed by the built in codecs.
+Other formats use the loadImageRowsFromData_ hook if installed, otherwise the image is decoded in
+full and then passed to the sink.
+*/
+bool loadImageRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode and scale an image using ScaleRowSink, so the full resolution image is never stored.
+ColorMap loadScaledImageFromData(const uint8_t* data, size_t size, size_t width, size_t height, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Memory map a file and decode it with loadScaledImageFromData.
+ColorMap loadScaledImage(const std::string& path, size_t width, size_t height, std::vector<std::string>& errors);
+
+//##################################################################################################
+ColorMap loadImageFromData(const uint8_t* data, size_t size, const LoadOptions& options, std::vector<std::string>& errors);
+
 //##################################################################################################
 ColorMap loadImageFromResource(const std::string& path);
 
@@ -36,6 +74,7 @@ ColorMap loadImageFromResource(const std::string& path, std::vector<std::string>
 //! List all image file in a directory.
 /*!
 This returns paths to all image files in a directory that the loadImage function can probably load.
+If the imagePaths_ hook is not installed the directory is listed with scanImagePaths().
 
 \param directory to search for images in.
 \return A list of absolute paths to image files contained in the provided directory.
@@ -49,12 +88,28 @@ std::vector<ColorMap> loadImages(const std::string& path, int64_t maxBytes=10737
 std::vector<ColorMap> loadImages(const std::string& path, std::vector<std::string>& names, int64_t maxBytes=1073741824);
 
 //##################################################################################################
+//! Load all images in a directory in parallel, passing each to a callback as soon as it is decoded.
+/*!
+The files are listed using imagePaths() and decoded on a pool of worker threads. Loading stops
+once the decoded images would exceed maxBytes, images that don't fit are discarded.
+
+\param path - The directory to load images from.
+\param imageLoaded - Called for each image in the order that they finish, calls are serialized.
+\param maxBytes - The maximum total size of the decoded images.
+*/
+void loadImages(const std::string& path,
+                const std::function<void(const std::string& name, const ColorMap& image)>& imageLoaded,
+                int64_t maxBytes=1073741824);
+
+//##################################################################################################
+//! Load an image saved with saveImageToJson, data can be either a base64 string or a json binary.
 ColorMap loadImageFromJson(const nlohmann::json& j);
 
 //##################################################################################################
 ColorMap loadImageFromJson(const nlohmann::json& j, std::vector<std::string>& errors);
 
 //##################################################################################################
+//! Load a ByteMap saved with saveByteMapToJson or saveByteMapToRLEJson.
 ByteMap loadByteMapFromJson(const nlohmann::json& j);
 
 //##################################################################################################
@@ -66,6 +121,9 @@ ColorMapF loadColorMapFFromData(const std::string& data);
 //##################################################################################################
 ColorMapF loadColorMapFFromData(const std::string& data, std::vector<std::string>& errors);
 
+//##################################################################################################
+ColorMapF loadColorMapFFromData(const uint8_t* data, size_t length, std::vector<std::string>& errors);
+
 //##################################################################################################
 std::vector<std::string> imageTypes();
 
@@ -92,6 +150,18 @@ std::vector<std::vector<uint8_t>> imagesToCharRGB(const std::vector<ColorMap>& i
 
 extern ColorMap (*loadImage_)(const std::string& path, std::vector<std::string>& errors);
 extern ColorMap (*loadImageFromData_)(const std::string& data, std::vector<std::string>& errors);
+
+//! Preferred over loadImageFromData_ as it does not require callers to copy their data into a std::string.
+extern ColorMap (*loadImageFromRawData_)(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//! Decoders that can reduce resolution while decoding should install these, they may return an
+//! image of any size as long as it is acceptable to options, the caller does the final scale.
+extern ColorMap (*loadImageWithOptions_)(const std::string& path, const LoadOptions& options, std::vector<std::string>& errors);
+extern ColorMap (*loadImageFromDataWithOptions_)(const uint8_t* data, size_t size, const LoadOptions& options, std::vector<std::string>& errors);
+
+//! Decoders that can produce rows as they go should install this so that loadScaledImage can
+//! decode large images in bounded memory.
+extern bool (*loadImageRowsFromData_)(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors);
 extern std::vector<std::string> (*imagePaths_)(const std::string& path);
 extern std::vector<ColorMap> (*loadImages_)(const std::string& path, std::vector<std::string>& names, int64_t maxBytes);
 
@@ -0,0 +1,79 @@
+#ifndef tp_image_utils_LoadImagesAsync_h
+#define tp_image_utils_LoadImagesAsync_h
+
+#include "tp_image_utils/Globals.h" // IWYU pragma: keep
+#include "tp_image_utils/ColorMap.h"
+
+#include <future>
+#include <functional>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Load an image on a background thread using the loadImage_ or loadImageFromData_ hooks.
+/*!
+File reading and decoding are performed on separate bounded thread pools so that a slow disk does
+not starve the decoder threads. Errors are printed as warnings.
+
+\param path - The path of the image file to load.
+\return A future that will hold the decoded image, or an empty image on failure.
+*/
+std::future<ColorMap> loadImageAsync(const std::string& path);
+
+//##################################################################################################
+//! Load an image on a background thread and pass it to completed.
+/*!
+\param path - The path of the image file to load.
+\param completed - Called from a pool thread once the image has been loaded.
+*/
+void loadImageAsync(const std::string& path,
+                    const std::function<void(const ColorMap& image, const std::vector<std::string>& errors)>& completed);
+
+//##################################################################################################
+//! Decode an image on a background thread using the loadImageFromData_ or loadImageFromRawData_ hooks.
+std::future<ColorMap> loadImageFromDataAsync(const std::string& data);
+
+//##################################################################################################
+//! Iterate over a list of images while loading the next few in the background.
+/*!
+This keeps up to lookAhead images loading ahead of the one returned by next(), allowing decoding to
+overlap with processing of the current image.
+
+\code
+tp_image_utils::PrefetchImageLoader loader(paths, 4);
+while(!loader.atEnd())
+  process(loader.next());
+\endcode
+*/
+class TP_IMAGE_UTILS_EXPORT PrefetchImageLoader
+{
+  TP_NONCOPYABLE(PrefetchImageLoader);
+public:
+  //################################################################################################
+  PrefetchImageLoader(const std::vector<std::string>& paths, size_t lookAhead=4);
+
+  //################################################################################################
+  //! Waits for any outstanding loads to complete.
+  ~PrefetchImageLoader();
+
+  //################################################################################################
+  [[nodiscard]] bool atEnd() const;
+
+  //################################################################################################
+  //! The index of the path that the next call to next() will return.
+  [[nodiscard]] size_t index() const;
+
+  //################################################################################################
+  //! Block until the next image is loaded and return it, also starts loading further images.
+  ColorMap next();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef tp_image_utils_LoadOptions_h
+#define tp_image_utils_LoadOptions_h
+
+#include "tp_image_utils/Scale.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Hints passed to decoders describing the size the image will be used at.
+/*!
+Decoders such as JPEG and WebP can decode at 1/2, 1/4 or 1/8 scale for a fraction of the cost of
+a full decode. Hooks that receive these options should use reductionFactor() to choose the
+largest reduction that still meets the minimum size, loadImage then finishes with an exact scale().
+*/
+struct LoadOptions
+{
+  size_t width{0};  //!< Target width, 0 to load at full size.
+  size_t height{0}; //!< Target height, 0 to load at full size.
+
+  ScaleMode scaleMode{ScaleMode::Stretch}; //!< How the final scale() fits the image to the target.
+
+  //! The smallest decoded size accepted, as a fraction of the size needed to fill the target. The
+  //! default of 1 means the final scale will only ever shrink the image, lower values trade
+  //! quality for speed by allowing it to enlarge.
+  float minimumFraction{1.0f};
+
+  //! Rotate and flip the image as described by its EXIF orientation. The target size is the size
+  //! after orientation, so decoders are passed the options with the width and height swapped for
+  //! orientations that transpose the image.
+  bool applyOrientation{false};
+
+  //################################################################################################
+  bool hasTarget() const;
+
+  //################################################################################################
+  //! Returns the largest power of 2 up to maxFactor that an image can be reduced by.
+  /*!
+  \param width - The full width of the image being decoded.
+  \param height - The full height of the image being decoded.
+  \param maxFactor - The largest factor the decoder supports, 8 for JPEG.
+  */
+  size_t reductionFactor(size_t width, size_t height, size_t maxFactor=8) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef tp_image_utils_MappedFile_h
+#define tp_image_utils_MappedFile_h
+
+#include "tp_image_utils/Globals.h"
+
+#include <memory>
+
+#if defined(TP_LINUX) || defined(TP_OSX)
+#define TP_IMAGE_UTILS_MMAP
+#endif
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! A read only view of a whole file.
+/*!
+Where supported the file is memory mapped so pages are only read from disk as they are touched,
+on other platforms the file is read into memory.
+*/
+class TP_IMAGE_UTILS_EXPORT MappedFile
+{
+  TP_NONCOPYABLE(MappedFile);
+  MappedFile();
+public:
+  //################################################################################################
+  ~MappedFile();
+
+  //################################################################################################
+  //! Returns nullptr if the file could not be opened.
+  static std::shared_ptr<MappedFile> open(const std::string& path, std::vector<std::string>& errors);
+
+  //################################################################################################
+  [[nodiscard]] const uint8_t* data() const;
+
+  //################################################################################################
+  [[nodiscard]] size_t size() const;
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
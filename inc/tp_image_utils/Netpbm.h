@@ -0,0 +1,58 @@
+#ifndef tp_image_utils_Netpbm_h
+#define tp_image_utils_Netpbm_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/ColorMapF.h"
+#include "tp_image_utils/ByteMap.h"
+#include "tp_image_utils/RowSink.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! The parsed header of a binary PGM (P5), PPM (P6) or PFM (PF/Pf) image.
+struct NetpbmHeader
+{
+  char type{0};          //!< '5', '6', 'F' or 'f' the second character of the magic number.
+  size_t width{0};
+  size_t height{0};
+  uint32_t maxValue{0};  //!< PGM/PPM only, values above 255 use 2 bytes per sample.
+  float scale{0.0f};     //!< PFM only, negative for little endian.
+  size_t dataOffset{0};  //!< Offset of the first byte of pixel data.
+};
+
+//##################################################################################################
+bool readNetpbmHeader(const uint8_t* data, size_t size, NetpbmHeader& header, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Encode a binary 8 bit PGM.
+std::string savePGMToData(const ByteMap& image);
+
+//##################################################################################################
+//! Encode a binary 8 bit PPM, alpha is dropped.
+std::string savePPMToData(const ColorMap& image);
+
+//##################################################################################################
+//! Encode a little endian RGB PFM, alpha is dropped.
+std::string savePFMToData(const ColorMapF& image);
+
+//##################################################################################################
+//! Decode a PGM or PPM into a ByteMap, color images are converted to gray.
+ByteMap loadPGMFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode a PGM or PPM into a ColorMap, 16 bit samples are reduced to 8 bits.
+ColorMap loadPPMFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode a PGM or PPM one row at a time into sink.
+bool loadPPMRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode a PFM into a ColorMapF, alpha is set to 1.
+ColorMapF loadPFMFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef tp_image_utils_PNG_h
+#define tp_image_utils_PNG_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/ByteMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+enum class PNGFilter
+{
+  Sub, //!< Predict each byte from the pixel to its left.
+  Up   //!< Predict each byte from the pixel above, usually better for screenshots and masks.
+};
+
+//##################################################################################################
+struct PNGOptions
+{
+  PNGFilter filter{PNGFilter::Up};
+
+  //! Only search for repeated pixels rather than general matches, faster but compresses less.
+  bool rleOnly{false};
+
+  //! Rows are split into chunks that are deflated in parallel, 0 picks a size automatically.
+  size_t rowsPerChunk{0};
+};
+
+//##################################################################################################
+//! Encode an RGBA PNG tuned for speed rather than size.
+/*!
+The filtered rows are compressed with a small LZ77 matcher and the fixed deflate Huffman tables.
+Large images are split into chunks of rows that are deflated independently on multiple threads
+and joined with empty stored blocks, so the result is a single valid zlib stream.
+*/
+std::string savePNGToData(const ColorMap& image, const PNGOptions& options=PNGOptions());
+
+//##################################################################################################
+//! Encode an 8 bit grayscale PNG tuned for speed rather than size.
+std::string savePNGToData(const ByteMap& image, const PNGOptions& options=PNGOptions());
+
+}
+
+#endif
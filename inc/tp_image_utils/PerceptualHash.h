@@ -0,0 +1,52 @@
+#ifndef tp_image_utils_PerceptualHash_h
+#define tp_image_utils_PerceptualHash_h
+
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+enum class PerceptualHashType
+{
+  Average,    //!< 8x8 gray image, each bit is set if the pixel is brighter than the mean.
+  Difference, //!< 9x8 gray image, each bit is set if a pixel is brighter than the one to its left.
+  DCT         //!< 32x32 gray image, each bit is set if a low frequency AC DCT coefficient is above the median.
+};
+
+//##################################################################################################
+//! A 64 bit hash that changes little when an image is scaled, re-encoded, or slightly edited.
+/*!
+The image is reduced with scale() and converted with toGray(), so the hash ignores aspect ratio and
+color. Similar images have hashes with a small hammingDistance(), typically less than 10 for
+re-encoded copies. Use a HammingIndex to search large numbers of hashes.
+
+The bits are laid out in row major order as an 8x8 grid, bit y*8+x is:
+ - Average - Set if cell (x, y) of the 8x8 image is brighter than the mean.
+ - Difference - Set if cell (x+1, y) of the 9x8 image is brighter than cell (x, y).
+ - DCT - Set if the DCT coefficient with horizontal frequency x+1 and vertical frequency y+1 is
+   above the median of the 64 coefficients. The DC term is not used.
+*/
+uint64_t perceptualHash(const ColorMap& image, PerceptualHashType type=PerceptualHashType::DCT);
+
+//##################################################################################################
+//! Hash a list of images in parallel.
+std::vector<uint64_t> perceptualHashes(const std::vector<ColorMap>& images, PerceptualHashType type=PerceptualHashType::DCT);
+
+//##################################################################################################
+//! Load and hash a list of image files in parallel.
+/*!
+Each file is loaded with LoadOptions targeting 32x32 so that decoders that support it can decode at
+reduced resolution. Files that fail to load get a hash of 0 and an error is added to errors.
+*/
+std::vector<uint64_t> perceptualHashesFromFiles(const std::vector<std::string>& paths,
+                                                PerceptualHashType type,
+                                                std::vector<std::string>& errors);
+
+//##################################################################################################
+//! The number of bits that differ between two hashes.
+int hammingDistance(uint64_t a, uint64_t b);
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 
 namespace tp_image_utils
 {
@@ -8,4 +9,7 @@ namespace tp_image_utils
 //##################################################################################################
 bool pngSize(const std::string& data, size_t& width, size_t& height);
 
+//##################################################################################################
+bool pngSize(const uint8_t* data, size_t size, size_t& width, size_t& height);
+
 }
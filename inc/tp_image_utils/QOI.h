@@ -0,0 +1,34 @@
+#ifndef tp_image_utils_QOI_h
+#define tp_image_utils_QOI_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/RowSink.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Encode an image using the lossless QOI format.
+/*!
+QOI compresses a little less than PNG but encodes and decodes many times faster, making it a good
+choice for intermediate images and caches. See https://qoiformat.org for the specification.
+
+This is used by saveImage and saveImageToData when no other codec has been installed.
+*/
+std::string saveQOIToData(const ColorMap& image);
+
+//##################################################################################################
+//! Decode a QOI image, QOI data passed to loadImageFromData is always decoded using this.
+ColorMap loadQOIFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+ColorMap loadQOIFromData(const std::string& data, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode a QOI image one row at a time into sink.
+bool loadQOIRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors);
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef tp_image_utils_RLE_h
+#define tp_image_utils_RLE_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ByteMap.h"
+#include "tp_image_utils/IndexMap.h"
+
+#include "json.hpp"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Save a mask or label map as run lengths in the style of COCO.
+/*!
+Pixels are scanned row by row and stored as {"w", "h", "rle":{"counts", ...}}. The counts use the
+compressed string encoding from the COCO API. Where the runs alternate between two values, as they
+do for masks, those values are stored once in "palette", otherwise the value of each run is stored
+in "values" using the same string encoding.
+
+Note that unlike COCO the runs are row major.
+*/
+nlohmann::json saveByteMapToRLEJson(const ByteMap& image);
+
+//##################################################################################################
+nlohmann::json saveIndexMapToRLEJson(const IndexMap& image);
+
+//##################################################################################################
+//! Decode json from saveByteMapToRLEJson, runs are written to the image as they are parsed.
+/*!
+loadByteMapFromJson calls this for json that contains "rle".
+*/
+ByteMap loadByteMapFromRLEJson(const nlohmann::json& j, std::vector<std::string>& errors);
+
+//##################################################################################################
+IndexMap loadIndexMapFromRLEJson(const nlohmann::json& j, std::vector<std::string>& errors);
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef tp_image_utils_RawImage_h
+#define tp_image_utils_RawImage_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/ColorMapF.h"
+#include "tp_image_utils/ByteMap.h"
+#include "tp_image_utils/IndexMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! The pixel formats that can be stored in the raw image container.
+/*!
+The raw container is a versioned header followed by uncompressed rows of pixels at an aligned
+offset. This allows ColorMap and ColorMapF files to be memory mapped and used without decoding.
+*/
+enum class RawPixelType : uint32_t
+{
+  Unknown = 0,
+  RGBA8   = 1, //!< ColorMap
+  RGBA32F = 2, //!< ColorMapF
+  Gray8   = 3, //!< ByteMap
+  Index32 = 4  //!< IndexMap
+};
+
+//##################################################################################################
+std::string saveRawImageToData(const ColorMap& image);
+
+//##################################################################################################
+std::string saveRawImageToData(const ColorMapF& image);
+
+//##################################################################################################
+std::string saveRawImageToData(const ByteMap& image);
+
+//##################################################################################################
+std::string saveRawImageToData(const IndexMap& image);
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const ColorMap& image);
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const ColorMapF& image);
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const ByteMap& image);
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const IndexMap& image);
+
+//##################################################################################################
+//! Map a raw ColorMap file into memory and wrap it without copying.
+ColorMap loadRawColorMap(const std::string& path, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Map a raw ColorMapF file into memory and wrap it without copying.
+ColorMapF loadRawColorMapF(const std::string& path, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Map a raw ByteMap file into memory and copy the pixels out, ByteMap can't reference external data.
+ByteMap loadRawByteMap(const std::string& path, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Map a raw IndexMap file into memory and copy the pixels out, IndexMap can't reference external data.
+IndexMap loadRawIndexMap(const std::string& path, std::vector<std::string>& errors);
+
+//##################################################################################################
+ColorMap loadRawColorMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+ColorMapF loadRawColorMapFFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+ByteMap loadRawByteMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+IndexMap loadRawIndexMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef tp_image_utils_RowSink_h
+#define tp_image_utils_RowSink_h
+
+#include "tp_image_utils/ColorMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Receives an image from a decoder one row at a time.
+/*!
+Decoders call begin() once with the full size of the image, then for each row from top to bottom
+they call row() to get a buffer, write width pixels into it, and then call rowComplete(). The sink
+owns the row buffers, so a sink that keeps the whole image can hand out pointers into it while a
+streaming sink can reuse a single row.
+
+Any of the calls can return false to abort decoding.
+*/
+class TP_IMAGE_UTILS_EXPORT RowSink
+{
+public:
+  //################################################################################################
+  virtual ~RowSink();
+
+  //################################################################################################
+  virtual bool begin(size_t width, size_t height)=0;
+
+  //################################################################################################
+  //! Returns a buffer of at least width pixels for row y.
+  virtual TPPixel* row(size_t y)=0;
+
+  //################################################################################################
+  virtual bool rowComplete(size_t y)=0;
+};
+
+//##################################################################################################
+//! Collects the rows into a ColorMap, rows are decoded straight into the image.
+class TP_IMAGE_UTILS_EXPORT ColorMapRowSink : public RowSink
+{
+public:
+  //################################################################################################
+  bool begin(size_t width, size_t height) override;
+
+  //################################################################################################
+  TPPixel* row(size_t y) override;
+
+  //################################################################################################
+  bool rowComplete(size_t y) override;
+
+  //################################################################################################
+  ColorMap takeImage();
+
+private:
+  ColorMap m_image;
+  TPPixel* m_data{nullptr};
+};
+
+}
+
+#endif
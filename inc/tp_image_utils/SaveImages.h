@@ -9,14 +9,17 @@
 #include "json.hpp"
 
 #include <vector>
+#include <memory>
 
 namespace tp_image_utils
 {
 
 //##################################################################################################
+//! Save using the saveImage_ hook, or the built in QOI, PNG, BMP, TGA or PPM encoders if no hook is installed.
 bool saveImage(const std::string& path, const ColorMap& image);
 
 //##################################################################################################
+//! Save using the saveImageToData_ hook, or as QOI if no hook is installed.
 std::string saveImageToData(const ColorMap& image);
 
 //##################################################################################################
@@ -26,18 +29,51 @@ std::string saveJPEGToData(const tp_image_utils::ColorMap& image, int quality);
 std::string saveWebPToData(const tp_image_utils::ColorMap& image, int quality);
 
 //##################################################################################################
-nlohmann::json saveImageToJson(const ColorMap& image);
+//! Save the image as {"w", "h", "data"}, the pixels are base64 encoded straight into the json.
+/*!
+\param binary - Store the pixels as a json binary value instead of base64, this is much faster
+and smaller when the json is serialized using CBOR or MessagePack but should not be used for text.
+*/
+nlohmann::json saveImageToJson(const ColorMap& image, bool binary=false);
 
 //##################################################################################################
-nlohmann::json saveByteMapToJson(const ByteMap& image);
+nlohmann::json saveByteMapToJson(const ByteMap& image, bool binary=false);
 
 //##################################################################################################
 std::string saveColorMapFToData(const ColorMapF& image);
 
+//##################################################################################################
+//! Codec state that an encoder hook can keep between calls, for example a libjpeg compressor.
+/*!
+Each context is only ever used by one thread at a time, see BatchEncoder.
+*/
+class TP_IMAGE_UTILS_EXPORT EncoderContext
+{
+public:
+  //################################################################################################
+  virtual ~EncoderContext();
+};
+
+//##################################################################################################
+//! Encode into output reusing its capacity, using the buffer hooks if installed.
+/*!
+If the hook for the format has not been installed this falls back to saveJPEGToData_ or
+saveWebPToData_, the result is moved into output so its capacity is not reused.
+
+\param context - Passed to the hook which can create and keep its codec state in it.
+\return false if encoding failed or no encoder is installed.
+*/
+bool saveJPEGToBuffer(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context);
+
+//##################################################################################################
+bool saveWebPToBuffer(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context);
+
 extern bool (*saveImage_)(const std::string& path, const ColorMap& image);
 extern std::string (*saveImageToData_)(const ColorMap& image);
 extern std::string (*saveJPEGToData_)(const tp_image_utils::ColorMap& image, int quality);
 extern std::string (*saveWebPToData_)(const tp_image_utils::ColorMap& image, int quality);
+extern bool (*saveJPEGToBuffer_)(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context);
+extern bool (*saveWebPToBuffer_)(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context);
 }
 
 #endif
@@ -4,6 +4,7 @@
 #include "tp_image_utils/ByteMap.h"
 #include "tp_image_utils/ColorMap.h"
 #include "tp_image_utils/ColorMapF.h"
+#include "tp_image_utils/RowSink.h"
 
 #include "tp_utils/TimeUtils.h"
 
@@ -339,6 +340,43 @@ Container scale(const Container& src,
 //##################################################################################################
 void halfScaleInPlace(ColorMap& img);
 
+//##################################################################################################
+//! A streaming version of the area resampler used by scale(), in stretch mode.
+/*!
+Rows are resampled horizontally as they arrive and accumulated into the few destination rows that
+they overlap, each destination row is finished as soon as the last source row that covers it has
+been received. Memory use depends only on the destination size, so huge images can be decoded and
+scaled without ever holding the full resolution image.
+*/
+class TP_IMAGE_UTILS_EXPORT ScaleRowSink : public RowSink
+{
+  TP_NONCOPYABLE(ScaleRowSink);
+public:
+  //################################################################################################
+  ScaleRowSink(size_t width, size_t height);
+
+  //################################################################################################
+  ~ScaleRowSink() override;
+
+  //################################################################################################
+  bool begin(size_t width, size_t height) override;
+
+  //################################################################################################
+  TPPixel* row(size_t y) override;
+
+  //################################################################################################
+  bool rowComplete(size_t y) override;
+
+  //################################################################################################
+  //! Returns the scaled image, empty if decoding did not complete.
+  ColorMap takeImage();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
 }
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef tp_image_utils_TGA_h
+#define tp_image_utils_TGA_h
+
+#include "tp_image_utils/Globals.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/ByteMap.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! Encode a 32 bit BGRA TGA, optionally run length encoded.
+std::string saveTGAToData(const ColorMap& image, bool rle=true);
+
+//##################################################################################################
+//! Encode an 8 bit grayscale TGA, optionally run length encoded.
+std::string saveTGAToData(const ByteMap& image, bool rle=true);
+
+//##################################################################################################
+//! Returns true if data starts with a supported TGA header that is consistent with its size.
+/*!
+TGA has no magic number, so this is only a plausibility check used before trying data as TGA.
+*/
+bool isTGAHeader(const uint8_t* data, size_t size);
+
+//##################################################################################################
+//! Decode a raw or RLE, 24 or 32 bit color or 8 bit grayscale TGA.
+ColorMap loadTGAFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+//##################################################################################################
+//! Decode a TGA into a ByteMap, color images are converted to the mean of red, green, and blue.
+ByteMap loadTGAByteMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors);
+
+}
+
+#endif
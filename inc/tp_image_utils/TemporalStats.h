@@ -0,0 +1,104 @@
+#ifndef tp_image_utils_TemporalStats_h
+#define tp_image_utils_TemporalStats_h
+
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/ColorMapF.h"
+#include "tp_image_utils/ByteMap.h"
+
+namespace tp_image_utils
+{
+class AbstractImageSequence;
+
+//##################################################################################################
+//! Per pixel statistics accumulated one frame at a time.
+/*!
+Frames are folded in as they are added so that only the accumulators are held in memory: a running
+mean and variance using Welford's method, the minimum, the maximum, and optionally a histogram per
+pixel and channel for the approximate median. Rows are updated in parallel.
+
+Frames must either all be ColorMaps, giving RGBA statistics, or all be ByteMaps giving gray
+statistics. Float results are in the 0 to 1 range used by toFloat(), gray results have the value
+in r, g, and b with an opaque alpha, or an alpha of 0 for the variance and standard deviation.
+
+The median histograms take width*height*channels*medianBins*2 bytes, so use a small number of bins
+for large images. The median is interpolated within the bin that contains it.
+*/
+class TP_IMAGE_UTILS_EXPORT TemporalStats
+{
+  TP_NONCOPYABLE(TemporalStats);
+public:
+  //################################################################################################
+  /*!
+  \param medianBins - Histogram bins for the median, a power of 2 up to 256, 0 disables the median.
+  */
+  TemporalStats(size_t medianBins=0);
+
+  //################################################################################################
+  ~TemporalStats();
+
+  //################################################################################################
+  //! Add a frame, this fails if it is a different size or type to the previous frames.
+  bool add(const ColorMap& image, std::vector<std::string>& errors);
+
+  //################################################################################################
+  bool add(const ByteMap& image, std::vector<std::string>& errors);
+
+  //################################################################################################
+  //! Remove all frames.
+  void clear();
+
+  //################################################################################################
+  //! The number of frames that have been added.
+  size_t count() const;
+
+  //################################################################################################
+  size_t width() const;
+
+  //################################################################################################
+  size_t height() const;
+
+  //################################################################################################
+  //! 4 for ColorMap frames, 1 for ByteMap frames, 0 before the first frame.
+  size_t channels() const;
+
+  //################################################################################################
+  ColorMapF mean() const;
+
+  //################################################################################################
+  //! The population variance.
+  ColorMapF variance() const;
+
+  //################################################################################################
+  ColorMapF standardDeviation() const;
+
+  //################################################################################################
+  ColorMap minimum() const;
+
+  //################################################################################################
+  ColorMap maximum() const;
+
+  //################################################################################################
+  //! The approximate median, this is empty if medianBins was 0.
+  ColorMapF median() const;
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+//##################################################################################################
+//! Add frames first, first+stride, ... up to last from a sequence to stats.
+/*!
+\return The number of frames added.
+*/
+size_t addFrames(AbstractImageSequence& sequence,
+                 size_t first,
+                 size_t last,
+                 size_t stride,
+                 TemporalStats& stats,
+                 std::vector<std::string>& errors);
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef tp_image_utils_WorkerPool_h
+#define tp_image_utils_WorkerPool_h
+
+#include "tp_image_utils/Globals.h"
+
+#include <functional>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+//! A fixed number of threads that execute tasks from a shared queue.
+class TP_IMAGE_UTILS_EXPORT WorkerPool
+{
+  TP_NONCOPYABLE(WorkerPool);
+public:
+  //################################################################################################
+  //! Create a pool, if nThreads is 0 the hardware concurrency will be used.
+  WorkerPool(size_t nThreads=0);
+
+  //################################################################################################
+  //! Finishes the queued tasks and joins the threads.
+  ~WorkerPool();
+
+  //################################################################################################
+  size_t nThreads() const;
+
+  //################################################################################################
+  //! Add a task to the queue, this returns immediately.
+  void run(const std::function<void()>& task);
+
+  //################################################################################################
+  //! Block until all tasks that have been queued so far have completed.
+  void waitForIdle();
+
+private:
+  struct Private;
+  friend struct Private;
+  Private* d;
+};
+
+}
+
+#endif
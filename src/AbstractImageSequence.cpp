@@ -1,4 +1,6 @@
 #include "tp_image_utils/AbstractImageSequence.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/ImageDirectorySequence.h"
 
 namespace tp_image_utils
 {
@@ -7,6 +9,50 @@ std::vector<std::function<AbstractImageSequence*(const std::string&)>> AbstractI
 //##################################################################################################
 AbstractImageSequence::~AbstractImageSequence()=default;
 
+//##################################################################################################
+void AbstractImageSequence::loadImages(size_t first,
+                                       size_t last,
+                                       size_t stride,
+                                       const std::function<bool(size_t, const ColorMap&)>& imageLoaded)
+{
+  stride = tpMax(size_t(1), stride);
+
+  if(size_t count = frameCount(); count>0)
+    last = tpMin(last, count);
+
+  for(size_t i=first; i<last; i+=stride)
+  {
+    ColorMap image = loadImage(i);
+    if(image.size()<1 || !imageLoaded(i, image))
+      return;
+
+    // Stop before i overflows when last is the maximum size_t.
+    if(last-i<=stride)
+      return;
+  }
+}
+
+//##################################################################################################
+size_t AbstractImageSequence::frameCount()
+{
+  return 0;
+}
+
+//##################################################################################################
+bool AbstractImageSequence::frameSize(size_t& width, size_t& height)
+{
+  ColorMap image = loadImage(0);
+  width = image.width();
+  height = image.height();
+  return image.size()>0;
+}
+
+//##################################################################################################
+std::vector<size_t> AbstractImageSequence::keyframeIndices()
+{
+  return {};
+}
+
 //##################################################################################################
 AbstractImageSequence* AbstractImageSequence::loadSequence(const std::string& data)
 {
@@ -14,6 +60,10 @@ AbstractImageSequence* AbstractImageSequence::loadSequence(const std::string& da
     if(auto s=factory(data); s)
       return s;
 
+  // Built in, a directory of images or a numbered pattern like frame_%05d.png.
+  if(data.size()<4096 && data.find('\0')==std::string::npos)
+    return ImageDirectorySequence::open(data);
+
   return nullptr;
 }
 
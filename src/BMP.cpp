@@ -0,0 +1,225 @@
+#include "tp_image_utils/BMP.h"
+
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t fileHeaderSize=14;
+constexpr size_t infoHeaderSize=40;
+
+//##################################################################################################
+inline void write16(uint8_t*& d, uint32_t v)
+{
+  d[0] = uint8_t(v);
+  d[1] = uint8_t(v>>8);
+  d+=2;
+}
+
+//##################################################################################################
+inline void write32(uint8_t*& d, uint32_t v)
+{
+  write16(d, v & 0xFFFF);
+  write16(d, v>>16);
+}
+
+//##################################################################################################
+inline uint32_t read16(const uint8_t* s)
+{
+  return uint32_t(s[0]) | (uint32_t(s[1])<<8);
+}
+
+//##################################################################################################
+inline uint32_t read32(const uint8_t* s)
+{
+  return read16(s) | (read16(s+2)<<16);
+}
+}
+
+//##################################################################################################
+std::string saveBMPToData(const ColorMap& image, bool alpha)
+{
+  size_t w = image.width();
+  size_t h = image.height();
+  if(w<1 || h<1)
+    return std::string();
+
+  size_t bytesPerPixel = alpha?4:3;
+  size_t stride = (w*bytesPerPixel + 3) & ~size_t(3);
+  size_t offset = fileHeaderSize + infoHeaderSize;
+  size_t total = offset + stride*h;
+
+  std::string result;
+  result.resize(total);
+  auto d = reinterpret_cast<uint8_t*>(result.data());
+
+  *(d++) = 'B';
+  *(d++) = 'M';
+  write32(d, uint32_t(total));
+  write32(d, 0);
+  write32(d, uint32_t(offset));
+
+  write32(d, infoHeaderSize);
+  write32(d, uint32_t(w));
+  write32(d, uint32_t(h)); // Positive height means the rows are stored bottom up.
+  write16(d, 1);
+  write16(d, uint32_t(bytesPerPixel*8));
+  write32(d, 0); // BI_RGB
+  write32(d, uint32_t(stride*h));
+  write32(d, 2835); // 72 DPI
+  write32(d, 2835);
+  write32(d, 0);
+  write32(d, 0);
+
+  for(size_t y=h; y>0; y--)
+  {
+    const TPPixel* s = image.constData() + (y-1)*w;
+    uint8_t* row = d;
+    for(size_t x=0; x<w; x++, s++)
+    {
+      *(d++) = s->b;
+      *(d++) = s->g;
+      *(d++) = s->r;
+      if(alpha)
+        *(d++) = s->a;
+    }
+
+    std::memset(d, 0, stride - size_t(d-row));
+    d = row + stride;
+  }
+
+  return result;
+}
+
+//##################################################################################################
+bool loadBMPRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors)
+{
+  if(size<fileHeaderSize+infoHeaderSize || data[0]!='B' || data[1]!='M')
+  {
+    errors.push_back("Not a BMP image.");
+    return false;
+  }
+
+  size_t offset = read32(data+10);
+  size_t headerSize = read32(data+14);
+  if(headerSize<infoHeaderSize)
+  {
+    errors.push_back("Unsupported BMP header size: " + std::to_string(headerSize));
+    return false;
+  }
+
+  auto width  = int32_t(read32(data+18));
+  auto height = int32_t(read32(data+22));
+  uint32_t bitsPerPixel = read16(data+28);
+  uint32_t compression = read32(data+30);
+
+  // BI_BITFIELDS is accepted for 32 bit images with the common BGRA masks.
+  bool bitfields = (compression==3 && bitsPerPixel==32);
+  if((compression!=0 && !bitfields) || (bitsPerPixel!=24 && bitsPerPixel!=32))
+  {
+    errors.push_back("Unsupported BMP format, bits: " + std::to_string(bitsPerPixel) + " compression: " + std::to_string(compression));
+    return false;
+  }
+
+  // The masks follow a 40 byte header and sit at the same offset inside V4/V5 headers.
+  if(bitfields)
+  {
+    constexpr size_t masksOffset = fileHeaderSize+infoHeaderSize;
+    if(size<masksOffset+12)
+    {
+      errors.push_back("BMP bitfield masks truncated.");
+      return false;
+    }
+
+    uint32_t rMask = read32(data+masksOffset);
+    uint32_t gMask = read32(data+masksOffset+4);
+    uint32_t bMask = read32(data+masksOffset+8);
+    if(rMask!=0x00FF0000 || gMask!=0x0000FF00 || bMask!=0x000000FF)
+    {
+      errors.push_back("Unsupported BMP bitfield masks.");
+      return false;
+    }
+  }
+
+  bool topDown = height<0;
+  size_t w = size_t(width);
+  size_t h = size_t(topDown?-int64_t(height):int64_t(height));
+  size_t bytesPerPixel = bitsPerPixel/8;
+  size_t stride = (w*bytesPerPixel + 3) & ~size_t(3);
+
+  if(width<1 || h<1 || offset>size || h>(size-offset)/stride)
+  {
+    errors.push_back("BMP data truncated or invalid, w: " + std::to_string(width) + " h: " + std::to_string(height));
+    return false;
+  }
+
+  // Many writers leave the 4th byte as 0 in 32 bit images, treat that as opaque. This normally
+  // stops at the first pixel.
+  uint8_t opaque = 255;
+  if(bytesPerPixel==4)
+  {
+    for(size_t y=0; y<h && opaque; y++)
+    {
+      const uint8_t* s = data + offset + y*stride + 3;
+      const uint8_t* sMax = s + w*4;
+      for(; s<sMax; s+=4)
+      {
+        if(*s)
+        {
+          opaque = 0;
+          break;
+        }
+      }
+    }
+  }
+
+  if(!sink.begin(w, h))
+    return false;
+
+  // The data is in memory so bottom up images can still be passed to the sink top down.
+  for(size_t y=0; y<h; y++)
+  {
+    const uint8_t* s = data + offset + (topDown?y:(h-1-y))*stride;
+    TPPixel* d = sink.row(y);
+    TPPixel* dMax = d + w;
+
+    if(bytesPerPixel==4)
+    {
+      for(; d<dMax; d++, s+=4)
+      {
+        d->r = s[2];
+        d->g = s[1];
+        d->b = s[0];
+        d->a = s[3] | opaque;
+      }
+    }
+    else
+    {
+      for(; d<dMax; d++, s+=3)
+      {
+        d->r = s[2];
+        d->g = s[1];
+        d->b = s[0];
+        d->a = 255;
+      }
+    }
+
+    if(!sink.rowComplete(y))
+      return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+ColorMap loadBMPFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  ColorMapRowSink sink;
+  if(!loadBMPRowsFromData(data, size, sink, errors))
+    return ColorMap();
+  return sink.takeImage();
+}
+
+}
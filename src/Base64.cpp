@@ -0,0 +1,238 @@
+#include "tp_image_utils/Base64.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define TP_IMAGE_UTILS_BASE64_SSSE3
+#  include <immintrin.h>
+#endif
+
+namespace tp_image_utils
+{
+
+namespace
+{
+const char* encodeTable = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+//##################################################################################################
+struct DecodeTable
+{
+  int8_t values[256];
+
+  //################################################################################################
+  DecodeTable()
+  {
+    for(auto& v : values)
+      v = -1;
+
+    for(int i=0; i<64; i++)
+      values[uint8_t(encodeTable[i])] = int8_t(i);
+  }
+};
+
+//##################################################################################################
+const DecodeTable& decodeTable()
+{
+  static const DecodeTable table;
+  return table;
+}
+
+#ifdef TP_IMAGE_UTILS_BASE64_SSSE3
+//##################################################################################################
+bool hasSSSE3()
+{
+  static const bool result = __builtin_cpu_supports("ssse3");
+  return result;
+}
+
+//##################################################################################################
+//! Encode 12 bytes at a time, returns the number of bytes consumed.
+/*!
+Based on the pshufb lookup described by Wojciech Muła, http://0x80.pl/articles/index.html#base64
+Each iteration loads 16 bytes so this stops while there are still at least 4 bytes left over.
+*/
+__attribute__((target("ssse3"))) size_t encodeSSSE3(const uint8_t* src, size_t size, char* dst)
+{
+  const __m128i shuffle  = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m128i shiftLUT = _mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+                                         '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '+'-62,
+                                         '/'-63, 'A', 0, 0);
+
+  size_t i=0;
+  for(; i+16<=size; i+=12, dst+=16)
+  {
+    __m128i in = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i)), shuffle);
+
+    // Split each 3 bytes into 4 6 bit indices.
+    __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+    __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t0, t1);
+
+    // Map indices to ASCII by adding an offset chosen per range.
+    __m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+    __m128i result = _mm_add_epi8(_mm_shuffle_epi8(shiftLUT, reduced), indices);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), result);
+  }
+
+  return i;
+}
+
+//##################################################################################################
+//! Decode 16 characters at a time, returns the number consumed or size+1 on invalid input.
+/*!
+Each iteration writes 16 bytes of which 12 are valid so this stops while the remaining output is
+large enough to absorb the over write.
+*/
+__attribute__((target("ssse3"))) size_t decodeSSSE3(const char* src, size_t size, uint8_t* dst)
+{
+  const __m128i shiftLUT  = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i maskLUT   = _mm_setr_epi8(int8_t(0xA8),
+                                          int8_t(0xF8), int8_t(0xF8), int8_t(0xF8), int8_t(0xF8), int8_t(0xF8),
+                                          int8_t(0xF8), int8_t(0xF8), int8_t(0xF8), int8_t(0xF8),
+                                          int8_t(0xF0), int8_t(0x54),
+                                          int8_t(0x50), int8_t(0x50), int8_t(0x50),
+                                          int8_t(0x54));
+  const __m128i bitposLUT = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, int8_t(0x80), 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i pack      = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  size_t i=0;
+  for(; i+24<=size; i+=16, dst+=12)
+  {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src+i));
+
+    __m128i higher = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+    __m128i lower  = _mm_and_si128(in, _mm_set1_epi8(0x0F));
+
+    // Validate using a bitmask per high nibble, anything outside the alphabet fails.
+    __m128i m = _mm_shuffle_epi8(maskLUT, lower);
+    __m128i bit = _mm_shuffle_epi8(bitposLUT, higher);
+    __m128i nonMatch = _mm_cmpeq_epi8(_mm_and_si128(m, bit), _mm_setzero_si128());
+    if(_mm_movemask_epi8(nonMatch))
+      return size+1;
+
+    // '/' shares its high nibble with '+' so needs its own shift.
+    __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    __m128i shift = _mm_or_si128(_mm_andnot_si128(slash, _mm_shuffle_epi8(shiftLUT, higher)),
+                                 _mm_and_si128(slash, _mm_set1_epi8(16)));
+    __m128i values = _mm_add_epi8(in, shift);
+
+    // Join 4 6 bit values into 3 bytes.
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(merged, pack));
+  }
+
+  return i;
+}
+#endif
+
+//##################################################################################################
+size_t stripPadding(const char* src, size_t size)
+{
+  for(int i=0; i<2 && size>0 && src[size-1]=='='; i++)
+    size--;
+  return size;
+}
+}
+
+//##################################################################################################
+size_t base64EncodedSize(size_t size)
+{
+  return ((size+2)/3)*4;
+}
+
+//##################################################################################################
+void base64Encode(const uint8_t* src, size_t size, char* dst)
+{
+  size_t i=0;
+
+#ifdef TP_IMAGE_UTILS_BASE64_SSSE3
+  if(hasSSSE3())
+  {
+    i = encodeSSSE3(src, size, dst);
+    dst += (i/3)*4;
+  }
+#endif
+
+  for(; i+3<=size; i+=3, dst+=4)
+  {
+    uint32_t v = (uint32_t(src[i])<<16) | (uint32_t(src[i+1])<<8) | uint32_t(src[i+2]);
+    dst[0] = encodeTable[(v>>18) & 0x3F];
+    dst[1] = encodeTable[(v>>12) & 0x3F];
+    dst[2] = encodeTable[(v>> 6) & 0x3F];
+    dst[3] = encodeTable[ v      & 0x3F];
+  }
+
+  if(size_t remaining = size-i; remaining>0)
+  {
+    uint32_t v = uint32_t(src[i])<<16;
+    if(remaining==2)
+      v |= uint32_t(src[i+1])<<8;
+
+    dst[0] = encodeTable[(v>>18) & 0x3F];
+    dst[1] = encodeTable[(v>>12) & 0x3F];
+    dst[2] = (remaining==2)?encodeTable[(v>>6) & 0x3F]:'=';
+    dst[3] = '=';
+  }
+}
+
+//##################################################################################################
+size_t base64DecodedSize(const char* src, size_t size)
+{
+  size = stripPadding(src, size);
+  size_t tail = size%4;
+  return (size/4)*3 + ((tail>1)?(tail-1):0);
+}
+
+//##################################################################################################
+bool base64Decode(const char* src, size_t size, uint8_t* dst)
+{
+  size = stripPadding(src, size);
+  if(size%4 == 1)
+    return false;
+
+  size_t i=0;
+
+#ifdef TP_IMAGE_UTILS_BASE64_SSSE3
+  if(hasSSSE3())
+  {
+    i = decodeSSSE3(src, size, dst);
+    if(i>size)
+      return false;
+    dst += (i/4)*3;
+  }
+#endif
+
+  const int8_t* table = decodeTable().values;
+  auto value = [&](size_t c, uint32_t& bad)
+  {
+    int8_t v = table[uint8_t(src[c])];
+    bad |= uint32_t(v<0);
+    return uint32_t(uint8_t(v));
+  };
+
+  uint32_t bad=0;
+  for(; i+4<=size; i+=4, dst+=3)
+  {
+    uint32_t v = (value(i, bad)<<18) | (value(i+1, bad)<<12) | (value(i+2, bad)<<6) | value(i+3, bad);
+    dst[0] = uint8_t(v>>16);
+    dst[1] = uint8_t(v>>8);
+    dst[2] = uint8_t(v);
+  }
+
+  if(size_t remaining = size-i; remaining>1)
+  {
+    uint32_t v = (value(i, bad)<<18) | (value(i+1, bad)<<12);
+    if(remaining==3)
+      v |= value(i+2, bad)<<6;
+
+    dst[0] = uint8_t(v>>16);
+    if(remaining==3)
+      dst[1] = uint8_t(v>>8);
+  }
+
+  return bad==0;
+}
+
+}
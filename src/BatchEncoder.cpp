@@ -0,0 +1,132 @@
+#include "tp_image_utils/BatchEncoder.h"
+#include "tp_image_utils/SaveImages.h"
+#include "tp_image_utils/WorkerPool.h"
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct BatchEncoder::Private
+{
+  WorkerPool pool;
+
+  // Contexts are handed to whichever thread needs one, so there are never more than the number of
+  // threads in the pool and each is only used by one thread at a time.
+  struct Contexts
+  {
+    std::unique_ptr<EncoderContext> jpeg;
+    std::unique_ptr<EncoderContext> webp;
+  };
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Contexts>> freeContexts;
+
+  //################################################################################################
+  Private(size_t nThreads):
+    pool(nThreads)
+  {
+
+  }
+
+  //################################################################################################
+  std::unique_ptr<Contexts> takeContexts()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(freeContexts.empty())
+      return std::make_unique<Contexts>();
+
+    auto contexts = std::move(freeContexts.back());
+    freeContexts.pop_back();
+    return contexts;
+  }
+
+  //################################################################################################
+  void returnContexts(std::unique_ptr<Contexts> contexts)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeContexts.push_back(std::move(contexts));
+  }
+};
+
+//##################################################################################################
+BatchEncoder::BatchEncoder(size_t nThreads):
+  d(new Private(nThreads))
+{
+
+}
+
+//##################################################################################################
+BatchEncoder::~BatchEncoder()
+{
+  delete d;
+}
+
+//##################################################################################################
+BatchEncoder& BatchEncoder::instance()
+{
+  static BatchEncoder encoder;
+  return encoder;
+}
+
+//##################################################################################################
+bool BatchEncoder::encode(const ColorMap* images, size_t count, EncodeFormat format, int quality, std::vector<std::string>& outputs)
+{
+  outputs.resize(count);
+  if(count<1)
+    return true;
+
+  std::atomic<size_t> next{0};
+  std::atomic<bool> ok{true};
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t remaining = tpMin(count, d->pool.nThreads());
+  size_t nTasks = remaining;
+
+  // Each task keeps taking images until there are none left, so contexts are taken once per task
+  // rather than once per image.
+  auto task = [&]
+  {
+    auto contexts = d->takeContexts();
+    for(size_t i=next++; i<count; i=next++)
+    {
+      auto& output = outputs[i];
+      output.clear();
+
+      bool encoded = (format==EncodeFormat::JPEG)?
+            saveJPEGToBuffer(images[i], quality, output, contexts->jpeg):
+            saveWebPToBuffer(images[i], quality, output, contexts->webp);
+
+      if(!encoded)
+      {
+        output.clear();
+        ok = false;
+      }
+    }
+    d->returnContexts(std::move(contexts));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(--remaining==0)
+      finished.notify_all();
+  };
+
+  for(size_t t=0; t<nTasks; t++)
+    d->pool.run(task);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&]{return remaining==0;});
+
+  return ok;
+}
+
+//##################################################################################################
+bool BatchEncoder::encode(const std::vector<ColorMap>& images, EncodeFormat format, int quality, std::vector<std::string>& outputs)
+{
+  return encode(images.data(), images.size(), format, quality, outputs);
+}
+
+}
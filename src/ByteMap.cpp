@@ -217,4 +217,23 @@ void ByteMap::setColumn(size_t x, const std::vector<uint8_t>& values)
   }
 }
 
+//##################################################################################################
+uint64_t ByteMap::contentHash() const
+{
+  return contentHash128().low;
+}
+
+//##################################################################################################
+Hash128 ByteMap::contentHash128() const
+{
+  return imageContentHash128(m_data.data(), m_width, m_height, sizeof(uint8_t));
+}
+
+//##################################################################################################
+bool ByteMap::contentEquals(const ByteMap& other) const
+{
+  return m_width==other.m_width && m_height==other.m_height &&
+      tp_image_utils::contentEquals(m_data.data(), other.m_data.data(), m_data.size()*sizeof(uint8_t));
+}
+
 }
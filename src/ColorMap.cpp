@@ -14,7 +14,19 @@ namespace tp_image_utils
 //##################################################################################################
 struct ColorMap::SD
 {
-  std::unique_ptr<TPPixel[]> data;
+  //################################################################################################
+  //! Deletes owned data or releases the owner of wrapped external data.
+  struct Deleter
+  {
+    std::shared_ptr<const void> owner;
+    void operator()(TPPixel* p) const
+    {
+      if(!owner)
+        delete[] p;
+    }
+  };
+
+  std::unique_ptr<TPPixel[], Deleter> data;
   size_t width{0};
   size_t height{0};
 
@@ -25,17 +37,61 @@ struct ColorMap::SD
 
   std::atomic_int refCount{1};
 
+  // Cached contentHash128(), cleared by detach before any modification.
+  std::atomic_bool hasHash{false};
+  std::atomic<uint64_t> hashLow{0};
+  std::atomic<uint64_t> hashHigh{0};
+
+  //################################################################################################
+  //! Shared by all empty images so that default constructed and moved-from objects don't allocate.
+  //! The ref count never changes and is greater than 1 so writes always detach first.
+  static SD* empty()
+  {
+    static SD emptySD{2};
+    return &emptySD;
+  }
+
+  //################################################################################################
+  SD()=default;
+
+  //################################################################################################
+  explicit SD(int refCount_):
+    refCount(refCount_)
+  {
+
+  }
+
+  //################################################################################################
+  void ref()
+  {
+    if(this != empty())
+      refCount++;
+  }
+
+  //################################################################################################
+  static void deref(SD* sd)
+  {
+    if(sd != empty() && sd->refCount.fetch_sub(1)==1)
+      delete sd;
+  }
+
   //################################################################################################
   void detach(ColorMap* q, bool nocopy = false)
   {
-    if(refCount==1)
+    if(refCount==1 && !data.get_deleter().owner)
+    {
+      hasHash = false;
       return;
+    }
 
     auto newSD = new SD();
     if(!nocopy)
     {
-      newSD->data.reset(new TPPixel[width*height]);
-      memcpy(newSD->data.get(), data.get(), width*height*sizeof(TPPixel));
+      if(size_t s=width*height; s>0)
+      {
+        newSD->data.reset(new TPPixel[s]);
+        memcpy(newSD->data.get(), data.get(), s*sizeof(TPPixel));
+      }
 
       newSD->width = width;
       newSD->height = height;
@@ -43,16 +99,18 @@ struct ColorMap::SD
       newSD->fh = fh;
     }
 
-    if(refCount.fetch_sub(1)==1)
-      delete this;
+    deref(this);
 
     q->sd = newSD;
   }
 
   void detach(ColorMap* q, size_t newW, size_t newH)
   {
-    if(refCount==1)
+    if(refCount==1 && !data.get_deleter().owner)
+    {
+      hasHash = false;
       return;
+    }
 
     auto newSD = new SD();
     newSD->data.reset(new TPPixel[newW*newH]);
@@ -62,8 +120,7 @@ struct ColorMap::SD
     newSD->fw = fw;
     newSD->fh = fh;
 
-    if(refCount.fetch_sub(1)==1)
-      delete this;
+    deref(this);
 
     q->sd = newSD;
   }
@@ -74,15 +131,50 @@ struct ColorMap::SD
 ColorMap::ColorMap(const ColorMap& other):
   sd(other.sd)
 {
-  sd->refCount++;
+  sd->ref();
+}
+
+//##################################################################################################
+ColorMap::ColorMap(ColorMap&& other) noexcept:
+  sd(other.sd)
+{
+  other.sd = SD::empty();
+}
+
+//##################################################################################################
+ColorMap ColorMap::wrapReadOnly(size_t w, size_t h, const TPPixel* data, const std::shared_ptr<const void>& owner, float fw, float fh)
+{
+  if(!owner)
+  {
+    ColorMap image(w, h, data);
+    image.setFractionalSize(fw, fh);
+    return image;
+  }
+
+  ColorMap image;
+  image.sd = new SD();
+  image.sd->width = w;
+  image.sd->height = h;
+  image.sd->fw = fw;
+  image.sd->fh = fh;
+  image.sd->data = std::unique_ptr<TPPixel[], SD::Deleter>(const_cast<TPPixel*>(data), SD::Deleter{owner});
+  return image;
 }
 
 //##################################################################################################
 ColorMap::ColorMap(size_t w, size_t h, const TPPixel* data, const TPPixel &fill):
-  sd(new SD())
-{  
+  sd(SD::empty())
+{
+  if(w==0 && h==0)
+    return;
+
+  sd = new SD();
   sd->width = w;
   sd->height = h;
+
+  if(w*h==0)
+    return;
+
   sd->data.reset( new TPPixel[w*h]);
 
   if(data)
@@ -94,8 +186,7 @@ ColorMap::ColorMap(size_t w, size_t h, const TPPixel* data, const TPPixel &fill)
 //##################################################################################################
 ColorMap::~ColorMap()
 {
-  if(sd->refCount.fetch_sub(1)==1)
-    delete sd;
+  SD::deref(sd);
 }
 
 //##################################################################################################
@@ -104,17 +195,16 @@ ColorMap& ColorMap::operator=(const ColorMap& other)
   if(sd == other.sd)
     return *this;
 
-  if(sd->refCount.fetch_sub(1)==1)
-    delete sd;
+  SD::deref(sd);
 
   sd = other.sd;
-  sd->refCount++;
+  sd->ref();
 
   return *this;
 }
 
 //################################################################################################
-ColorMap& ColorMap::operator=(ColorMap&& other)
+ColorMap& ColorMap::operator=(ColorMap&& other) noexcept
 {
   if(sd == other.sd)
     return *this;
@@ -348,7 +438,7 @@ void ColorMap::setSize(size_t width, size_t height)
   sd->detach(this, true);
   sd->width = width;
   sd->height = height;
-  sd->data.reset(new TPPixel[size()]);
+  sd->data.reset((size()>0)?new TPPixel[size()]:nullptr);
 }
 
 //##################################################################################################
@@ -407,6 +497,7 @@ void ColorMap::clone2IntoOther(ColorMap& clone) const
 //##################################################################################################
 void ColorMap::setFractionalSize(float fw, float fh)
 {
+  sd->detach(this);
   sd->fw = fw;
   sd->fh = fh;
 }
@@ -429,4 +520,45 @@ bool ColorMap::sameObject(const ColorMap& other) const
   return sd == other.sd;
 }
 
+//##################################################################################################
+bool ColorMap::isShared() const
+{
+  return sd->refCount>1;
+}
+
+//##################################################################################################
+uint64_t ColorMap::contentHash() const
+{
+  return contentHash128().low;
+}
+
+//##################################################################################################
+Hash128 ColorMap::contentHash128() const
+{
+  if(sd->hasHash)
+    return {sd->hashLow, sd->hashHigh};
+
+  Hash128 hash = imageContentHash128(sd->data.get(), sd->width, sd->height, sizeof(TPPixel));
+  sd->hashLow = hash.low;
+  sd->hashHigh = hash.high;
+  sd->hasHash = true;
+  return hash;
+}
+
+//##################################################################################################
+bool ColorMap::contentEquals(const ColorMap& other) const
+{
+  if(sd==other.sd)
+    return true;
+
+  if(sd->width!=other.sd->width || sd->height!=other.sd->height)
+    return false;
+
+  // Differing hashes prove the pixels differ without reading them.
+  if(sd->hasHash && other.sd->hasHash && (sd->hashLow!=other.sd->hashLow || sd->hashHigh!=other.sd->hashHigh))
+    return false;
+
+  return tp_image_utils::contentEquals(sd->data.get(), other.sd->data.get(), sizeInBytes());
+}
+
 }
@@ -15,7 +15,19 @@ namespace tp_image_utils
 //##################################################################################################
 struct ColorMapF::SD
 {
-  std::unique_ptr<glm::vec4[]> data;
+  //################################################################################################
+  //! Deletes owned data or releases the owner of wrapped external data.
+  struct Deleter
+  {
+    std::shared_ptr<const void> owner;
+    void operator()(glm::vec4* p) const
+    {
+      if(!owner)
+        delete[] p;
+    }
+  };
+
+  std::unique_ptr<glm::vec4[], Deleter> data;
   size_t width{0};
   size_t height{0};
 
@@ -26,18 +38,62 @@ struct ColorMapF::SD
 
   std::atomic_int refCount{1};
 
+  // Cached contentHash128(), cleared by detach before any modification.
+  std::atomic_bool hasHash{false};
+  std::atomic<uint64_t> hashLow{0};
+  std::atomic<uint64_t> hashHigh{0};
+
+  //################################################################################################
+  //! Shared by all empty images so that default constructed and moved-from objects don't allocate.
+  //! The ref count never changes and is greater than 1 so writes always detach first.
+  static SD* empty()
+  {
+    static SD emptySD{2};
+    return &emptySD;
+  }
+
+  //################################################################################################
+  SD()=default;
+
+  //################################################################################################
+  explicit SD(int refCount_):
+    refCount(refCount_)
+  {
+
+  }
+
+  //################################################################################################
+  void ref()
+  {
+    if(this != empty())
+      refCount++;
+  }
+
+  //################################################################################################
+  static void deref(SD* sd)
+  {
+    if(sd != empty() && sd->refCount.fetch_sub(1)==1)
+      delete sd;
+  }
+
   //################################################################################################
   void detach(ColorMapF* q, bool nocopy = false)
   {
-    if(refCount==1)
+    if(refCount==1 && !data.get_deleter().owner)
+    {
+      hasHash = false;
       return;
+    }
 
     auto newSD = new SD();
 
     if(!nocopy)
     {
-      newSD->data.reset(new glm::vec4[width*height]);
-      memcpy(newSD->data.get(), data.get(),width*height*sizeof(glm::vec4));
+      if(size_t s=width*height; s>0)
+      {
+        newSD->data.reset(new glm::vec4[s]);
+        memcpy(newSD->data.get(), data.get(), s*sizeof(glm::vec4));
+      }
 
       newSD->width = width;
       newSD->height = height;
@@ -45,8 +101,7 @@ struct ColorMapF::SD
       newSD->fh = fh;
     }
 
-    if(refCount.fetch_sub(1)==1)
-      delete this;
+    deref(this);
 
     q->sd = newSD;
   }
@@ -56,15 +111,50 @@ struct ColorMapF::SD
 ColorMapF::ColorMapF(const ColorMapF& other):
   sd(other.sd)
 {
-  sd->refCount++;
+  sd->ref();
+}
+
+//##################################################################################################
+ColorMapF::ColorMapF(ColorMapF&& other) noexcept:
+  sd(other.sd)
+{
+  other.sd = SD::empty();
+}
+
+//##################################################################################################
+ColorMapF ColorMapF::wrapReadOnly(size_t w, size_t h, const glm::vec4* data, const std::shared_ptr<const void>& owner, float fw, float fh)
+{
+  if(!owner)
+  {
+    ColorMapF image(w, h, data);
+    image.setFractionalSize(fw, fh);
+    return image;
+  }
+
+  ColorMapF image;
+  image.sd = new SD();
+  image.sd->width = w;
+  image.sd->height = h;
+  image.sd->fw = fw;
+  image.sd->fh = fh;
+  image.sd->data = std::unique_ptr<glm::vec4[], SD::Deleter>(const_cast<glm::vec4*>(data), SD::Deleter{owner});
+  return image;
 }
 
 //##################################################################################################
 ColorMapF::ColorMapF(size_t w, size_t h, const glm::vec4* data, const glm::vec4& fill):
-  sd(new SD())
-{  
+  sd(SD::empty())
+{
+  if(w==0 && h==0)
+    return;
+
+  sd = new SD();
   sd->width = w;
   sd->height = h;
+
+  if(w*h==0)
+    return;
+
   sd->data.reset(new glm::vec4[w*h]);
   if(data){
     memcpy(sd->data.get(), data, w*h*sizeof(glm::vec4));
@@ -77,8 +167,7 @@ ColorMapF::ColorMapF(size_t w, size_t h, const glm::vec4* data, const glm::vec4&
 //##################################################################################################
 ColorMapF::~ColorMapF()
 {
-  if(sd->refCount.fetch_sub(1)==1)
-    delete sd;
+  SD::deref(sd);
 }
 
 //##################################################################################################
@@ -87,17 +176,16 @@ ColorMapF& ColorMapF::operator=(const ColorMapF& other)
   if(sd == other.sd)
     return *this;
 
-  if(sd->refCount.fetch_sub(1)==1)
-    delete sd;
+  SD::deref(sd);
 
   sd = other.sd;
-  sd->refCount++;
+  sd->ref();
 
   return *this;
 }
 
 //################################################################################################
-ColorMapF& ColorMapF::operator=(ColorMapF&& other)
+ColorMapF& ColorMapF::operator=(ColorMapF&& other) noexcept
 {
   if(sd == other.sd)
     return *this;
@@ -325,7 +413,7 @@ void ColorMapF::setSize(size_t width, size_t height)
   sd->detach(this, true);
   sd->width = width;
   sd->height = height;
-  sd->data.reset(new glm::vec4[size()]);
+  sd->data.reset((size()>0)?new glm::vec4[size()]:nullptr);
 }
 
 //##################################################################################################
@@ -384,6 +472,7 @@ void ColorMapF::clone2IntoOther(ColorMapF& clone) const
 //##################################################################################################
 void ColorMapF::setFractionalSize(float fw, float fh)
 {
+  sd->detach(this);
   sd->fw = fw;
   sd->fh = fh;
 }
@@ -401,4 +490,39 @@ float ColorMapF::fh() const
 }
 
 
+//##################################################################################################
+uint64_t ColorMapF::contentHash() const
+{
+  return contentHash128().low;
+}
+
+//##################################################################################################
+Hash128 ColorMapF::contentHash128() const
+{
+  if(sd->hasHash)
+    return {sd->hashLow, sd->hashHigh};
+
+  Hash128 hash = imageContentHash128(sd->data.get(), sd->width, sd->height, sizeof(glm::vec4));
+  sd->hashLow = hash.low;
+  sd->hashHigh = hash.high;
+  sd->hasHash = true;
+  return hash;
+}
+
+//##################################################################################################
+bool ColorMapF::contentEquals(const ColorMapF& other) const
+{
+  if(sd==other.sd)
+    return true;
+
+  if(sd->width!=other.sd->width || sd->height!=other.sd->height)
+    return false;
+
+  // Differing hashes prove the pixels differ without reading them.
+  if(sd->hasHash && other.sd->hasHash && (sd->hashLow!=other.sd->hashLow || sd->hashHigh!=other.sd->hashHigh))
+    return false;
+
+  return tp_image_utils::contentEquals(sd->data.get(), other.sd->data.get(), size()*sizeof(glm::vec4));
+}
+
 }
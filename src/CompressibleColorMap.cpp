@@ -0,0 +1,288 @@
+#include "tp_image_utils/CompressibleColorMap.h"
+#include "tp_image_utils/QOI.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <iterator>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+}
+
+//##################################################################################################
+struct CompressibleColorMap::Private
+{
+  ColorMap image;
+  std::string compressed;
+  size_t width{0};
+  size_t height{0};
+
+  // QOI only stores the size so the rest of the metadata is kept here.
+  float fw{1.0f};
+  float fh{1.0f};
+
+  bool resident{true};
+  std::list<Private*>::iterator lru;
+  Clock::time_point lastAccess;
+
+  //################################################################################################
+  //! Shared by all holders, the most recently used resident image is at the front of the list.
+  struct Registry
+  {
+    std::mutex mutex;
+    std::list<Private*> lru;
+    CompressibleColorMapStats stats;
+
+    //##############################################################################################
+    Registry()
+    {
+      stats.budget = 1073741824;
+    }
+  };
+
+  //################################################################################################
+  static Registry& registry()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  //################################################################################################
+  void setImage(Registry& r, const ColorMap& newImage)
+  {
+    if(resident)
+    {
+      r.stats.residentBytes -= image.sizeInBytes();
+      r.lru.splice(r.lru.begin(), r.lru, lru);
+    }
+    else
+      r.lru.push_front(this);
+
+    r.stats.compressedBytes -= compressed.size();
+    compressed = std::string();
+
+    image = newImage;
+    width = image.width();
+    height = image.height();
+    fw = image.fw();
+    fh = image.fh();
+    resident = true;
+    lru = r.lru.begin();
+    r.stats.residentBytes += image.sizeInBytes();
+  }
+
+  //################################################################################################
+  void touch(Registry& r)
+  {
+    lastAccess = Clock::now();
+
+    if(resident)
+    {
+      r.lru.splice(r.lru.begin(), r.lru, lru);
+      return;
+    }
+
+    std::vector<std::string> errors;
+    image = loadQOIFromData(compressed, errors);
+    for(const auto& error : errors)
+      tpWarning() << error;
+    image.setFractionalSize(fw, fh);
+
+    resident = true;
+    r.lru.push_front(this);
+    lru = r.lru.begin();
+    r.stats.residentBytes += image.sizeInBytes();
+    r.stats.decompressions++;
+
+    enforceBudget(r, this);
+  }
+
+  //################################################################################################
+  //! Returns false if the image is referenced elsewhere or could not be compressed.
+  bool compress(Registry& r)
+  {
+    if(!resident || image.isShared() || image.size()<1)
+      return false;
+
+    if(compressed.empty())
+    {
+      compressed = saveQOIToData(image);
+      if(compressed.empty())
+        return false;
+
+      r.stats.compressedBytes += compressed.size();
+      r.stats.compressions++;
+    }
+
+    r.stats.residentBytes -= image.sizeInBytes();
+    image = ColorMap();
+    resident = false;
+    r.lru.erase(lru);
+    return true;
+  }
+
+  //################################################################################################
+  static void enforceBudget(Registry& r, Private* except)
+  {
+    // i stays valid when the entry before it is removed by compress.
+    for(auto i=r.lru.end(); r.stats.residentBytes>r.stats.budget && i!=r.lru.begin();)
+    {
+      auto current = std::prev(i);
+      if(*current!=except && (*current)->compress(r))
+        continue;
+      i = current;
+    }
+  }
+};
+
+//##################################################################################################
+CompressibleColorMap::CompressibleColorMap(const ColorMap& image):
+  d(new Private())
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  d->resident = false;
+  d->lastAccess = Clock::now();
+  d->setImage(r, image);
+  r.stats.holders++;
+  Private::enforceBudget(r, d);
+}
+
+//##################################################################################################
+CompressibleColorMap::~CompressibleColorMap()
+{
+  {
+    auto& r = Private::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if(d->resident)
+    {
+      r.stats.residentBytes -= d->image.sizeInBytes();
+      r.lru.erase(d->lru);
+    }
+    r.stats.compressedBytes -= d->compressed.size();
+    r.stats.holders--;
+  }
+
+  delete d;
+}
+
+//##################################################################################################
+void CompressibleColorMap::setImage(const ColorMap& image)
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  d->lastAccess = Clock::now();
+  d->setImage(r, image);
+  Private::enforceBudget(r, d);
+}
+
+//##################################################################################################
+ColorMap CompressibleColorMap::image() const
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  d->touch(r);
+  return d->image;
+}
+
+//##################################################################################################
+const TPPixel* CompressibleColorMap::constData() const
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  d->touch(r);
+  return d->image.constData();
+}
+
+//##################################################################################################
+TPPixel* CompressibleColorMap::data()
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  d->touch(r);
+
+  // The pixels may be modified so the compressed copy is no longer valid.
+  r.stats.compressedBytes -= d->compressed.size();
+  d->compressed = std::string();
+
+  // Detaching may copy, the size is unchanged so the budget is too.
+  return d->image.data();
+}
+
+//##################################################################################################
+size_t CompressibleColorMap::width() const
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return d->width;
+}
+
+//##################################################################################################
+size_t CompressibleColorMap::height() const
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return d->height;
+}
+
+//##################################################################################################
+bool CompressibleColorMap::isCompressed() const
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return !d->resident;
+}
+
+//##################################################################################################
+void CompressibleColorMap::compress()
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  d->compress(r);
+}
+
+//##################################################################################################
+void CompressibleColorMap::setBudget(size_t bytes)
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.stats.budget = bytes;
+  Private::enforceBudget(r, nullptr);
+}
+
+//##################################################################################################
+void CompressibleColorMap::compressIdle(double seconds)
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+
+  auto cutoff = Clock::now() - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+
+  // The list is in access order so stop at the first image that has been used recently.
+  for(auto i=r.lru.end(); i!=r.lru.begin();)
+  {
+    auto current = std::prev(i);
+    if((*current)->lastAccess>cutoff)
+      break;
+
+    if(!(*current)->compress(r))
+      i = current;
+  }
+}
+
+//##################################################################################################
+CompressibleColorMapStats CompressibleColorMap::stats()
+{
+  auto& r = Private::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return r.stats;
+}
+
+}
@@ -0,0 +1,195 @@
+#include "tp_image_utils/ContentHash.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  define TP_IMAGE_UTILS_CONTENT_HASH_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#  include <intrin.h>
+#endif
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t stripeSize=64;
+constexpr size_t stripesPerBlock=16;
+constexpr size_t nAccumulators=8;
+
+// Stripe s uses keys s to s+7, followed by the scramble keys and the final mixing keys.
+constexpr size_t scrambleKeys = stripesPerBlock+nAccumulators;
+constexpr size_t lowKeys = scrambleKeys+nAccumulators;
+constexpr size_t highKeys = lowKeys+nAccumulators;
+constexpr size_t nKeys = highKeys+nAccumulators;
+
+constexpr uint64_t prime32_1 = 0x9E3779B1U;
+constexpr uint64_t prime32_2 = 0x85EBCA77U;
+constexpr uint64_t prime32_3 = 0xC2B2AE3DU;
+constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+#ifndef TP_IMAGE_UTILS_CONTENT_HASH_SSE2
+//##################################################################################################
+uint64_t read64(const uint8_t* p)
+{
+  // Little endian regardless of platform so that hashes can be stored.
+  uint64_t v=0;
+  for(size_t i=0; i<8; i++)
+    v |= uint64_t(p[i])<<(i*8);
+  return v;
+}
+#endif
+
+//##################################################################################################
+uint64_t splitmix64(uint64_t& state)
+{
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z>>30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z>>27)) * 0x94D049BB133111EBULL;
+  return z ^ (z>>31);
+}
+
+//##################################################################################################
+uint64_t mulFold64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 p = static_cast<unsigned __int128>(a) * b;
+  return uint64_t(p) ^ uint64_t(p>>64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  uint64_t high;
+  uint64_t low = _umul128(a, b, &high);
+  return low ^ high;
+#else
+  uint64_t aLo = a & 0xFFFFFFFF, aHi = a>>32;
+  uint64_t bLo = b & 0xFFFFFFFF, bHi = b>>32;
+  uint64_t ll = aLo*bLo, lh = aLo*bHi, hl = aHi*bLo, hh = aHi*bHi;
+  uint64_t cross = (ll>>32) + (hl & 0xFFFFFFFF) + lh;
+  uint64_t high = hh + (hl>>32) + (cross>>32);
+  uint64_t low = (cross<<32) | (ll & 0xFFFFFFFF);
+  return low ^ high;
+#endif
+}
+
+//##################################################################################################
+uint64_t avalanche(uint64_t h)
+{
+  h ^= h>>37;
+  h *= 0x165667919E3779F9ULL;
+  return h ^ (h>>32);
+}
+
+//##################################################################################################
+void accumulateStripe(uint64_t* acc, const uint8_t* data, const uint64_t* keys)
+{
+#ifdef TP_IMAGE_UTILS_CONTENT_HASH_SSE2
+  // The keys are generated on this platform so they are already in native order, the data is
+  // assumed to be little endian which holds for every platform with SSE2.
+  for(size_t i=0; i<nAccumulators; i+=2)
+  {
+    __m128i* a = reinterpret_cast<__m128i*>(acc+i);
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data+i*8));
+    __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys+i));
+    __m128i dk = _mm_xor_si128(d, k);
+    __m128i product = _mm_mul_epu32(dk, _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1)));
+    __m128i swapped = _mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2));
+    _mm_storeu_si128(a, _mm_add_epi64(_mm_add_epi64(_mm_loadu_si128(a), swapped), product));
+  }
+#else
+  for(size_t i=0; i<nAccumulators; i++)
+  {
+    uint64_t d = read64(data+i*8);
+    uint64_t dk = d ^ keys[i];
+    acc[i^1] += d;
+    acc[i] += (dk & 0xFFFFFFFF) * (dk>>32);
+  }
+#endif
+}
+
+//##################################################################################################
+void scramble(uint64_t* acc, const uint64_t* keys)
+{
+  for(size_t i=0; i<nAccumulators; i++)
+  {
+    uint64_t a = acc[i];
+    a ^= a>>47;
+    a ^= keys[i];
+    acc[i] = a * prime32_1;
+  }
+}
+
+//##################################################################################################
+uint64_t mergeAccumulators(const uint64_t* acc, const uint64_t* keys, uint64_t start)
+{
+  uint64_t result = start;
+  for(size_t i=0; i<nAccumulators; i+=2)
+    result += mulFold64(acc[i]^keys[i], acc[i+1]^keys[i+1]);
+  return avalanche(result);
+}
+}
+
+//##################################################################################################
+Hash128 contentHash128(const void* data, size_t size, uint64_t seed)
+{
+  uint64_t keys[nKeys];
+  uint64_t state = seed;
+  for(auto& key : keys)
+    key = splitmix64(state);
+
+  uint64_t acc[nAccumulators] =
+  {
+    prime32_3, prime64_1, prime64_2, prime64_3,
+    prime64_4, prime32_2, prime64_5, prime32_1
+  };
+
+  const auto* p = static_cast<const uint8_t*>(data);
+  size_t nStripes = size/stripeSize;
+  size_t stripe=0;
+  for(; stripe<nStripes; stripe++)
+  {
+    size_t s = stripe%stripesPerBlock;
+    accumulateStripe(acc, p+stripe*stripeSize, keys+s);
+    if(s==stripesPerBlock-1)
+      scramble(acc, keys+scrambleKeys);
+  }
+
+  // The tail is zero padded, the length in the final mix distinguishes it from real zeros.
+  if(size_t remaining = size%stripeSize; remaining>0)
+  {
+    uint8_t last[stripeSize]={};
+    std::memcpy(last, p+nStripes*stripeSize, remaining);
+    accumulateStripe(acc, last, keys+(stripe%stripesPerBlock));
+  }
+
+  Hash128 hash;
+  hash.low  = mergeAccumulators(acc, keys+lowKeys, uint64_t(size)*prime64_1);
+  hash.high = mergeAccumulators(acc, keys+highKeys, ~(uint64_t(size)*prime64_2));
+  return hash;
+}
+
+//##################################################################################################
+uint64_t contentHash64(const void* data, size_t size, uint64_t seed)
+{
+  return contentHash128(data, size, seed).low;
+}
+
+//##################################################################################################
+Hash128 imageContentHash128(const void* data, size_t width, size_t height, size_t bytesPerPixel)
+{
+  uint64_t seed = uint64_t(width)*prime64_1 ^ uint64_t(height)*prime64_2 ^ uint64_t(bytesPerPixel)*prime64_3;
+  return contentHash128(data, width*height*bytesPerPixel, seed);
+}
+
+//##################################################################################################
+bool contentEquals(const void* a, const void* b, size_t size)
+{
+  return a==b || size==0 || std::memcmp(a, b, size)==0;
+}
+
+}
@@ -0,0 +1,338 @@
+#include "tp_image_utils/DeltaFrameStore.h"
+
+#include <mutex>
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t tileSize=16;
+
+//##################################################################################################
+void writeVarint(std::vector<uint8_t>& out, size_t value)
+{
+  while(value>=0x80)
+  {
+    out.push_back(uint8_t(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(uint8_t(value));
+}
+
+//##################################################################################################
+size_t readVarint(const uint8_t*& p)
+{
+  size_t value=0;
+  for(size_t shift=0; ; shift+=7)
+  {
+    uint8_t b = *(p++);
+    value |= size_t(b & 0x7F) << shift;
+    if(!(b & 0x80))
+      return value;
+  }
+}
+
+//##################################################################################################
+uint32_t word(const TPPixel& pixel)
+{
+  uint32_t w;
+  std::memcpy(&w, &pixel, 4);
+  return w;
+}
+
+//##################################################################################################
+bool tileChanged(const TPPixel* a, const TPPixel* b, size_t w, size_t tw, size_t th)
+{
+  for(size_t y=0; y<th; y++, a+=w, b+=w)
+    if(std::memcmp(a, b, tw*sizeof(TPPixel))!=0)
+      return true;
+  return false;
+}
+
+//##################################################################################################
+//! Encode the XOR of the changed pixels in a tile as alternating runs of skipped and literal words.
+void encodeTile(std::vector<uint8_t>& out, const TPPixel* a, const TPPixel* b, size_t w, size_t tw, size_t th)
+{
+  uint32_t xors[tileSize*tileSize];
+  size_t n=0;
+  for(size_t y=0; y<th; y++, a+=w, b+=w)
+    for(size_t x=0; x<tw; x++)
+      xors[n++] = word(a[x]) ^ word(b[x]);
+
+  for(size_t i=0; i<n;)
+  {
+    size_t zeros=i;
+    while(zeros<n && xors[zeros]==0)
+      zeros++;
+
+    size_t literals=zeros;
+    while(literals<n && xors[literals]!=0)
+      literals++;
+
+    writeVarint(out, zeros-i);
+    writeVarint(out, literals-zeros);
+
+    size_t offset = out.size();
+    out.resize(offset + (literals-zeros)*4);
+    std::memcpy(out.data()+offset, xors+zeros, (literals-zeros)*4);
+
+    i = literals;
+  }
+}
+
+//##################################################################################################
+void decodeTile(const uint8_t*& p, TPPixel* dst, size_t w, size_t tw, size_t th)
+{
+  size_t n = tw*th;
+  for(size_t i=0; i<n;)
+  {
+    i += readVarint(p);
+    size_t literals = readVarint(p);
+    for(size_t l=0; l<literals; l++, i++, p+=4)
+    {
+      uint32_t x;
+      std::memcpy(&x, p, 4);
+      TPPixel& pixel = dst[(i/tw)*w + (i%tw)];
+      x ^= word(pixel);
+      std::memcpy(static_cast<void*>(&pixel), &x, 4);
+    }
+  }
+}
+}
+
+//##################################################################################################
+struct DeltaFrameStore::Private
+{
+  //################################################################################################
+  struct Frame
+  {
+    ColorMap keyframe;
+    std::vector<uint8_t> delta;
+    bool isKeyframe{false};
+  };
+
+  size_t keyframeInterval;
+
+  mutable std::mutex mutex;
+  std::vector<Frame> frames;
+  ColorMap previous;
+  size_t sinceKeyframe{0};
+  size_t bytes{0};
+  size_t uncompressedBytes{0};
+
+  // The last frame that was read, so that reading in order only applies one delta per frame.
+  mutable size_t cachedIndex{0};
+  mutable ColorMap cached;
+
+  //################################################################################################
+  Private(size_t keyframeInterval_):
+    keyframeInterval(tpMax(size_t(1), keyframeInterval_))
+  {
+
+  }
+
+  //################################################################################################
+  //! Encode the difference from previous to image, returns false if it would not be worthwhile.
+  bool encodeDelta(const ColorMap& image, std::vector<uint8_t>& out) const
+  {
+    size_t w = image.width();
+    size_t h = image.height();
+    size_t limit = image.sizeInBytes()/2;
+
+    const TPPixel* a = previous.constData();
+    const TPPixel* b = image.constData();
+
+    size_t tilesX = (w+tileSize-1)/tileSize;
+    size_t tilesY = (h+tileSize-1)/tileSize;
+    size_t nTiles = tilesX*tilesY;
+
+    std::vector<bool> changed(nTiles);
+    for(size_t t=0; t<nTiles; t++)
+    {
+      size_t tx = (t%tilesX)*tileSize;
+      size_t ty = (t/tilesX)*tileSize;
+      size_t o = ty*w + tx;
+      changed[t] = tileChanged(a+o, b+o, w, tpMin(tileSize, w-tx), tpMin(tileSize, h-ty));
+    }
+
+    // Alternating runs of unchanged and changed tiles, each changed tile followed by its pixels.
+    for(size_t t=0; t<nTiles;)
+    {
+      size_t unchanged=t;
+      while(unchanged<nTiles && !changed[unchanged])
+        unchanged++;
+
+      size_t end=unchanged;
+      while(end<nTiles && changed[end])
+        end++;
+
+      writeVarint(out, unchanged-t);
+      writeVarint(out, end-unchanged);
+
+      for(size_t c=unchanged; c<end; c++)
+      {
+        size_t tx = (c%tilesX)*tileSize;
+        size_t ty = (c/tilesX)*tileSize;
+        size_t o = ty*w + tx;
+        encodeTile(out, a+o, b+o, w, tpMin(tileSize, w-tx), tpMin(tileSize, h-ty));
+      }
+
+      if(out.size()>limit)
+        return false;
+
+      t = end;
+    }
+
+    return true;
+  }
+
+  //################################################################################################
+  static void applyDelta(const std::vector<uint8_t>& delta, ColorMap& image)
+  {
+    size_t w = image.width();
+    size_t h = image.height();
+    TPPixel* dst = image.data();
+
+    size_t tilesX = (w+tileSize-1)/tileSize;
+    size_t tilesY = (h+tileSize-1)/tileSize;
+    size_t nTiles = tilesX*tilesY;
+
+    const uint8_t* p = delta.data();
+    for(size_t t=0; t<nTiles;)
+    {
+      t += readVarint(p);
+      size_t changed = readVarint(p);
+      for(size_t c=0; c<changed; c++, t++)
+      {
+        size_t tx = (t%tilesX)*tileSize;
+        size_t ty = (t/tilesX)*tileSize;
+        decodeTile(p, dst + ty*w + tx, w, tpMin(tileSize, w-tx), tpMin(tileSize, h-ty));
+      }
+    }
+  }
+};
+
+//##################################################################################################
+DeltaFrameStore::DeltaFrameStore(size_t keyframeInterval):
+  d(new Private(keyframeInterval))
+{
+
+}
+
+//##################################################################################################
+DeltaFrameStore::~DeltaFrameStore()
+{
+  delete d;
+}
+
+//##################################################################################################
+size_t DeltaFrameStore::append(const ColorMap& image)
+{
+  Private::Frame frame;
+
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  bool sameSize = !d->frames.empty() &&
+      image.width()==d->previous.width() &&
+      image.height()==d->previous.height();
+
+  if(!sameSize || d->sinceKeyframe+1>=d->keyframeInterval || !d->encodeDelta(image, frame.delta))
+  {
+    frame.delta = std::vector<uint8_t>();
+    frame.keyframe = image;
+    frame.isKeyframe = true;
+    d->sinceKeyframe = 0;
+    d->bytes += image.sizeInBytes();
+  }
+  else
+  {
+    frame.delta.shrink_to_fit();
+    d->sinceKeyframe++;
+    d->bytes += frame.delta.size();
+  }
+
+  d->uncompressedBytes += image.sizeInBytes();
+  d->previous = image;
+  d->frames.push_back(std::move(frame));
+  return d->frames.size()-1;
+}
+
+//##################################################################################################
+ColorMap DeltaFrameStore::frame(size_t i) const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+
+  if(i>=d->frames.size())
+    return ColorMap();
+
+  if(d->frames.at(i).isKeyframe)
+    return d->frames.at(i).keyframe;
+
+  size_t k=i;
+  while(!d->frames.at(k).isKeyframe)
+    k--;
+
+  ColorMap image;
+  size_t from;
+  if(d->cached.size()>0 && d->cachedIndex>=k && d->cachedIndex<i)
+  {
+    image = d->cached;
+    from = d->cachedIndex+1;
+  }
+  else
+  {
+    image = d->frames.at(k).keyframe;
+    from = k+1;
+  }
+
+  for(size_t f=from; f<=i; f++)
+    Private::applyDelta(d->frames.at(f).delta, image);
+
+  d->cachedIndex = i;
+  d->cached = image;
+  return image;
+}
+
+//##################################################################################################
+size_t DeltaFrameStore::size() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->frames.size();
+}
+
+//##################################################################################################
+bool DeltaFrameStore::isKeyframe(size_t i) const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return i<d->frames.size() && d->frames.at(i).isKeyframe;
+}
+
+//##################################################################################################
+size_t DeltaFrameStore::bytes() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->bytes;
+}
+
+//##################################################################################################
+size_t DeltaFrameStore::uncompressedBytes() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->uncompressedBytes;
+}
+
+//##################################################################################################
+void DeltaFrameStore::clear()
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  d->frames.clear();
+  d->previous = ColorMap();
+  d->cached = ColorMap();
+  d->sinceKeyframe = 0;
+  d->bytes = 0;
+  d->uncompressedBytes = 0;
+}
+
+}
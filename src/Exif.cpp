@@ -0,0 +1,381 @@
+#include "tp_image_utils/Exif.h"
+#include "tp_image_utils/MappedFile.h"
+
+#include "tp_utils/Parallel.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t tileSize=32;
+
+//##################################################################################################
+uint32_t be16(const uint8_t* p){return (uint32_t(p[0])<<8) | uint32_t(p[1]);}
+uint32_t le16(const uint8_t* p){return (uint32_t(p[1])<<8) | uint32_t(p[0]);}
+uint32_t be32(const uint8_t* p){return (be16(p)<<16) | be16(p+2);}
+uint32_t le32(const uint8_t* p){return (le16(p+2)<<16) | le16(p);}
+
+//##################################################################################################
+//! Reads the entries of a TIFF IFD, every offset is checked against the size of the block.
+struct TiffReader
+{
+  const uint8_t* data;
+  size_t size;
+  bool le;
+
+  //################################################################################################
+  uint32_t u16(size_t offset) const {return le?le16(data+offset):be16(data+offset);}
+  uint32_t u32(size_t offset) const {return le?le32(data+offset):be32(data+offset);}
+
+  //################################################################################################
+  //! Calls closure(tag, type, count, entryOffset) for each entry of the IFD at offset.
+  template<typename T>
+  bool forEachEntry(size_t offset, const T& closure) const
+  {
+    if(offset>size || size-offset<2)
+      return false;
+
+    size_t count = tpMin(size_t(u16(offset)), (size-offset-2)/12);
+    for(size_t i=0; i<count; i++)
+    {
+      size_t e = offset+2+i*12;
+      closure(u16(e), u16(e+2), u32(e+4), e);
+    }
+    return true;
+  }
+
+  //################################################################################################
+  std::string ascii(uint32_t count, size_t entry) const
+  {
+    // Values of 4 bytes or less are stored in the entry, otherwise it holds an offset.
+    size_t offset = (count<=4)?(entry+8):size_t(u32(entry+8));
+    if(offset>size || count>size-offset)
+      return std::string();
+
+    const char* c = reinterpret_cast<const char*>(data+offset);
+    return std::string(c, strnlen(c, count));
+  }
+};
+
+//##################################################################################################
+bool parseTiff(const uint8_t* data, size_t size, ExifInfo& info)
+{
+  if(size<8)
+    return false;
+
+  TiffReader reader{data, size, data[0]=='I'};
+  if(!((data[0]=='I' && data[1]=='I') || (data[0]=='M' && data[1]=='M')) || reader.u16(2)!=42)
+    return false;
+
+  size_t exifIFD=0;
+  bool found = reader.forEachEntry(reader.u32(4), [&](uint32_t tag, uint32_t type, uint32_t count, size_t e)
+  {
+    switch(tag)
+    {
+      case 0x0112: info.orientation = int(reader.u16(e+8)); break;
+      case 0x0132: if(type==2) info.dateTime = reader.ascii(count, e); break;
+      case 0x8769: exifIFD = reader.u32(e+8); break;
+      default: break;
+    }
+  });
+
+  if(!found)
+    return false;
+
+  if(info.orientation<1 || info.orientation>8)
+    info.orientation = 1;
+
+  if(exifIFD)
+  {
+    reader.forEachEntry(exifIFD, [&](uint32_t tag, uint32_t type, uint32_t count, size_t e)
+    {
+      if(type!=2)
+        return;
+
+      switch(tag)
+      {
+        case 0x9003: info.dateTimeOriginal   = reader.ascii(count, e); break;
+        case 0x9004: info.dateTimeDigitized  = reader.ascii(count, e); break;
+        case 0x9011: info.offsetTimeOriginal = reader.ascii(count, e); break;
+        case 0x9291: info.subSecTimeOriginal = reader.ascii(count, e); break;
+        default: break;
+      }
+    });
+  }
+
+  return true;
+}
+
+//##################################################################################################
+//! Skip the "Exif\0\0" identifier that precedes the TIFF header in JPEG and some WebP files.
+bool parseExifBlock(const uint8_t* data, size_t size, ExifInfo& info)
+{
+  if(size>=6 && std::memcmp(data, "Exif\0\0", 6)==0)
+  {
+    data += 6;
+    size -= 6;
+  }
+
+  return parseTiff(data, size, info);
+}
+
+//##################################################################################################
+bool jpgExif(const uint8_t* data, size_t size, ExifInfo& info)
+{
+  size_t pos=2;
+  while(pos+4<=size)
+  {
+    if(data[pos]!=0xFF)
+      return false;
+
+    uint8_t marker = data[pos+1];
+    if(marker==0xFF)
+    {
+      pos++;
+      continue;
+    }
+
+    pos+=2;
+
+    if(marker==0xD8 || marker==0x01 || (marker>=0xD0 && marker<=0xD7))
+      continue;
+
+    // EXIF always comes before the image data.
+    if(marker==0xD9 || marker==0xDA)
+      return false;
+
+    size_t length = be16(data+pos);
+    if(length<2 || length>size-pos)
+      return false;
+
+    if(marker==0xE1 && length>=8 && std::memcmp(data+pos+2, "Exif\0\0", 6)==0)
+      return parseExifBlock(data+pos+2, length-2, info);
+
+    pos+=length;
+  }
+
+  return false;
+}
+
+//##################################################################################################
+bool pngExif(const uint8_t* data, size_t size, ExifInfo& info)
+{
+  size_t pos=8;
+  while(pos+12<=size)
+  {
+    size_t length = be32(data+pos);
+    const uint8_t* type = data+pos+4;
+    if(length>size-pos-12)
+      return false;
+
+    if(std::memcmp(type, "eXIf", 4)==0)
+      return parseExifBlock(data+pos+8, length, info);
+
+    // Before PNG 1.5 eXIf was allowed after the image data, but in practice it comes first.
+    if(std::memcmp(type, "IDAT", 4)==0 || std::memcmp(type, "IEND", 4)==0)
+      return false;
+
+    pos += length+12;
+  }
+
+  return false;
+}
+
+//##################################################################################################
+bool webpExif(const uint8_t* data, size_t size, ExifInfo& info)
+{
+  if(size<12 || std::memcmp(data, "RIFF", 4)!=0 || std::memcmp(data+8, "WEBP", 4)!=0)
+    return false;
+
+  size_t pos=12;
+  while(pos+8<=size)
+  {
+    size_t length = le32(data+pos+4);
+    if(length>size-pos-8)
+      return false;
+
+    if(std::memcmp(data+pos, "EXIF", 4)==0)
+      return parseExifBlock(data+pos+8, length, info);
+
+    // Chunks are padded to an even size.
+    pos += 8 + length + (length&1);
+  }
+
+  return false;
+}
+
+//##################################################################################################
+//! Days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+int64_t daysFromCivil(int64_t y, int64_t m, int64_t d)
+{
+  y -= (m<=2)?1:0;
+  int64_t era = ((y>=0)?y:(y-399)) / 400;
+  int64_t yoe = y - era*400;
+  int64_t doy = (153*(m + ((m>2)?-3:9)) + 2)/5 + d - 1;
+  int64_t doe = yoe*365 + yoe/4 - yoe/100 + doy;
+  return era*146097 + doe - 719468;
+}
+
+//##################################################################################################
+bool parseDigits(const std::string& s, size_t pos, size_t n, int64_t& value)
+{
+  if(pos+n>s.size())
+    return false;
+
+  value=0;
+  for(size_t i=pos; i<pos+n; i++)
+  {
+    if(s[i]<'0' || s[i]>'9')
+      return false;
+    value = value*10 + (s[i]-'0');
+  }
+  return true;
+}
+}
+
+//##################################################################################################
+bool ExifInfo::timestampMS(int64_t& ms) const
+{
+  const std::string& s = dateTimeOriginal.empty()?dateTime:dateTimeOriginal;
+
+  int64_t year, month, day, hour, minute, second;
+  if(!parseDigits(s, 0, 4, year) || !parseDigits(s, 5, 2, month) || !parseDigits(s, 8, 2, day) ||
+     !parseDigits(s, 11, 2, hour) || !parseDigits(s, 14, 2, minute) || !parseDigits(s, 17, 2, second))
+    return false;
+
+  // Unknown dates are written with zeros.
+  if(month<1 || month>12 || day<1 || day>31)
+    return false;
+
+  ms = ((daysFromCivil(year, month, day)*24 + hour)*60 + minute)*60 + second;
+  ms *= 1000;
+
+  if(&s==&dateTimeOriginal)
+  {
+    // Sub second digits are fractions, so "5" is 500ms.
+    int64_t scale=100;
+    for(size_t i=0; i<subSecTimeOriginal.size() && scale>0 && subSecTimeOriginal[i]>='0' && subSecTimeOriginal[i]<='9'; i++, scale/=10)
+      ms += (subSecTimeOriginal[i]-'0')*scale;
+
+    int64_t offsetHours, offsetMinutes;
+    const std::string& o = offsetTimeOriginal;
+    if(o.size()>=6 && (o[0]=='+' || o[0]=='-') && parseDigits(o, 1, 2, offsetHours) && parseDigits(o, 4, 2, offsetMinutes))
+    {
+      int64_t offset = (offsetHours*60 + offsetMinutes)*60000;
+      ms -= (o[0]=='+')?offset:-offset;
+    }
+  }
+
+  return true;
+}
+
+//##################################################################################################
+bool readExif(const uint8_t* data, size_t size, ExifInfo& info)
+{
+  info = ExifInfo();
+
+  switch(guessImageFormat(data, tpMin(size, size_t(16)), std::string()))
+  {
+    case FileType::jpg:  return jpgExif(data, size, info);
+    case FileType::png:  return pngExif(data, size, info);
+    case FileType::webp: return webpExif(data, size, info);
+    case FileType::tiff: return parseTiff(data, size, info);
+    default: return false;
+  }
+}
+
+//##################################################################################################
+bool readExif(const std::string& data, ExifInfo& info)
+{
+  return readExif(reinterpret_cast<const uint8_t*>(data.data()), data.size(), info);
+}
+
+//##################################################################################################
+bool readExifFromFile(const std::string& path, ExifInfo& info)
+{
+  std::vector<std::string> errors;
+  auto file = MappedFile::open(path, errors);
+  if(!file)
+  {
+    info = ExifInfo();
+    return false;
+  }
+
+  return readExif(file->data(), file->size(), info);
+}
+
+//##################################################################################################
+bool orientationSwapsAxes(int orientation)
+{
+  return orientation>=5 && orientation<=8;
+}
+
+//##################################################################################################
+ColorMap applyOrientation(const ColorMap& image, int orientation)
+{
+  if(orientation<2 || orientation>8 || image.size()<1)
+    return image;
+
+  auto w = int64_t(image.width());
+  auto h = int64_t(image.height());
+
+  // Each destination pixel (x, y) is read from src[start + x*stepX + y*stepY].
+  int64_t start=0;
+  int64_t stepX=1;
+  int64_t stepY=w;
+  switch(orientation)
+  {
+    case 2: start = w-1;         stepX = -1; stepY =  w; break; // Flip horizontal.
+    case 3: start = w*h-1;       stepX = -1; stepY = -w; break; // Rotate 180.
+    case 4: start = (h-1)*w;     stepX =  1; stepY = -w; break; // Flip vertical.
+    case 5: start = 0;           stepX =  w; stepY =  1; break; // Transpose.
+    case 6: start = (h-1)*w;     stepX = -w; stepY =  1; break; // Rotate 90 CW.
+    case 7: start = (h-1)*w+w-1; stepX = -w; stepY = -1; break; // Transverse.
+    case 8: start = w-1;         stepX =  w; stepY = -1; break; // Rotate 90 CCW.
+  }
+
+  bool swap = orientationSwapsAxes(orientation);
+  size_t dw = size_t(swap?h:w);
+  size_t dh = size_t(swap?w:h);
+
+  ColorMap dst(dw, dh);
+  TPPixel* dstData = dst.data();
+  const TPPixel* src = image.constData() + start;
+
+  // Work in bands of rows, walking each band in tiles so that the source columns read by a
+  // transpose stay in cache.
+  size_t bands = (dh+tileSize-1)/tileSize;
+  std::atomic<size_t> c{0};
+  tp_utils::parallel([&](auto /*locker*/)
+  {
+    for(;;)
+    {
+      size_t const band=c++;
+
+      if(band>=bands)
+        return;
+
+      size_t y0 = band*tileSize;
+      size_t y1 = tpMin(y0+tileSize, dh);
+      for(size_t x0=0; x0<dw; x0+=tileSize)
+      {
+        size_t x1 = tpMin(x0+tileSize, dw);
+        for(size_t y=y0; y<y1; y++)
+        {
+          TPPixel* o = dstData + y*dw;
+          const TPPixel* i = src + int64_t(y)*stepY;
+          for(size_t x=x0; x<x1; x++)
+            o[x] = i[int64_t(x)*stepX];
+        }
+      }
+    }
+  });
+
+  return dst;
+}
+
+}
@@ -0,0 +1,357 @@
+#include "tp_image_utils/FrameReader.h"
+#include "tp_image_utils/AbstractImageSequence.h"
+#include "tp_image_utils/WorkerPool.h"
+
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t latencySamples=256;
+}
+
+//##################################################################################################
+struct FrameReader::Private
+{
+  //################################################################################################
+  struct Entry
+  {
+    std::shared_future<ColorMap> image;
+    std::list<size_t>::iterator lru;
+    size_t bytes{0};
+    bool loaded{false};
+    bool requested{false}; //!< Set once frame() waits on it, so it won't be skipped as stale.
+    size_t id{0};          //!< Identifies the decode that will fill this entry.
+  };
+
+  AbstractImageSequence* sequence;
+  size_t lookAhead;
+  bool serialize;
+
+  mutable std::mutex mutex;
+  std::mutex sequenceMutex;
+
+  size_t maxBytes;
+
+  // Most recently used at the front, only contains entries that have finished loading.
+  std::list<size_t> lru;
+  std::unordered_map<size_t, Entry> entries;
+  FrameReaderStats stats;
+
+  // Access pattern.
+  bool hasLast{false};
+  size_t last{0};
+  int64_t lastDelta{0};
+  int64_t stride{0};
+  int64_t step{0};
+  size_t generation{0};
+  size_t nextId{0};
+
+  // The first frame that the sequence returned an empty image for.
+  size_t end{std::numeric_limits<size_t>::max()};
+
+  std::vector<double> latencies;
+  size_t latencyIndex{0};
+
+  bool stopping{false};
+
+  // Declared last so that the threads are joined before anything they use is destroyed.
+  WorkerPool pool;
+
+  //################################################################################################
+  Private(AbstractImageSequence* sequence_, size_t maxBytes_, size_t lookAhead_, size_t nThreads):
+    sequence(sequence_),
+    lookAhead(lookAhead_),
+    serialize(nThreads<=1),
+    maxBytes(maxBytes_),
+    pool(tpMax(size_t(1), nThreads))
+  {
+
+  }
+
+  //################################################################################################
+  ColorMap loadFrame(size_t i)
+  {
+    if(!serialize)
+      return sequence->loadImage(i);
+
+    std::lock_guard<std::mutex> lock(sequenceMutex);
+    return sequence->loadImage(i);
+  }
+
+  //################################################################################################
+  //! Call with the mutex locked.
+  void evict()
+  {
+    while(stats.bytes>maxBytes && !lru.empty())
+    {
+      auto i = entries.find(lru.back());
+      stats.bytes -= i->second.bytes;
+      stats.count--;
+      stats.evictions++;
+      entries.erase(i);
+      lru.pop_back();
+    }
+  }
+
+  //################################################################################################
+  void store(size_t i, const ColorMap& image, size_t id)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Only store into the entry that this decode was for, it could have been cleared and replaced.
+    auto e = entries.find(i);
+    if(e==entries.end() || e->second.loaded || e->second.id!=id)
+      return;
+
+    if(image.size()<1)
+    {
+      end = tpMin(end, i);
+      entries.erase(e);
+      return;
+    }
+
+    e->second.loaded = true;
+    e->second.bytes = image.size()*sizeof(TPPixel);
+    lru.push_front(i);
+    e->second.lru = lru.begin();
+    stats.bytes += e->second.bytes;
+    stats.count++;
+    evict();
+  }
+
+  //################################################################################################
+  //! Call with the mutex locked.
+  void updatePattern(size_t i)
+  {
+    int64_t delta = hasLast?(int64_t(i)-int64_t(last)):1;
+    last = i;
+    hasLast = true;
+
+    if(delta==0)
+      return;
+
+    // A distance seen twice in a row is trusted for the full look ahead, otherwise only guess 1 frame.
+    stride = (delta==lastDelta)?delta:0;
+    lastDelta = delta;
+
+    if(delta!=step)
+    {
+      step = delta;
+      generation++;
+    }
+  }
+
+  //################################################################################################
+  //! Call with the mutex locked.
+  void prefetch(size_t i)
+  {
+    size_t n = (stride!=0)?lookAhead:tpMin(lookAhead, size_t(1));
+    for(size_t k=1; k<=n; k++)
+    {
+      int64_t j = int64_t(i) + int64_t(k)*step;
+      if(j<0 || size_t(j)>=end)
+        break;
+
+      if(entries.find(size_t(j))==entries.end())
+        schedule(size_t(j));
+    }
+  }
+
+  //################################################################################################
+  //! Call with the mutex locked.
+  void schedule(size_t i)
+  {
+    auto promise = std::make_shared<std::promise<ColorMap>>();
+    auto& entry = entries[i];
+    entry.image = promise->get_future().share();
+    entry.id = nextId++;
+    size_t id = entry.id;
+    size_t g = generation;
+
+    pool.run([this, i, g, id, promise]
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto e = entries.find(i);
+        bool stale = (g!=generation) && (e==entries.end() || !e->second.requested);
+        if(stopping || stale)
+        {
+          if(e!=entries.end() && e->second.id==id && !e->second.loaded && !e->second.requested)
+            entries.erase(e);
+          promise->set_value(ColorMap());
+          return;
+        }
+      }
+
+      ColorMap image = loadFrame(i);
+      promise->set_value(image);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.prefetched++;
+      }
+
+      store(i, image, id);
+    });
+  }
+
+  //################################################################################################
+  void recordLatency(double seconds)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(latencies.size()<latencySamples)
+      latencies.push_back(seconds);
+    else
+      latencies[latencyIndex] = seconds;
+    latencyIndex = (latencyIndex+1) % latencySamples;
+  }
+};
+
+//##################################################################################################
+FrameReader::FrameReader(AbstractImageSequence* sequence, size_t maxBytes, size_t lookAhead, size_t nThreads):
+  d(new Private(sequence, maxBytes, lookAhead, nThreads))
+{
+  if(size_t count = sequence->frameCount(); count>0)
+    d->end = count;
+}
+
+//##################################################################################################
+FrameReader::~FrameReader()
+{
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->stopping = true;
+  }
+  delete d;
+}
+
+//##################################################################################################
+ColorMap FrameReader::frame(size_t i)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  std::shared_future<ColorMap> future;
+  std::promise<ColorMap> promise;
+  bool decodeHere=false;
+  size_t id=0;
+
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->stats.requests++;
+    d->updatePattern(i);
+
+    if(auto e = d->entries.find(i); e!=d->entries.end())
+    {
+      if(e->second.loaded)
+      {
+        d->stats.hits++;
+        d->lru.splice(d->lru.begin(), d->lru, e->second.lru);
+      }
+      else
+      {
+        d->stats.waits++;
+        e->second.requested = true;
+      }
+      future = e->second.image;
+    }
+    else
+    {
+      d->stats.misses++;
+      auto& entry = d->entries[i];
+      entry.image = promise.get_future().share();
+      entry.requested = true;
+      entry.id = d->nextId++;
+      id = entry.id;
+      future = entry.image;
+      decodeHere = true;
+    }
+
+    d->prefetch(i);
+  }
+
+  if(decodeHere)
+  {
+    ColorMap image = d->loadFrame(i);
+    promise.set_value(image);
+    d->store(i, image, id);
+  }
+
+  ColorMap image = future.get();
+  d->recordLatency(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  return image;
+}
+
+//##################################################################################################
+int64_t FrameReader::stride() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->stride;
+}
+
+//##################################################################################################
+void FrameReader::setMaxBytes(size_t maxBytes)
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  d->maxBytes = maxBytes;
+  d->evict();
+}
+
+//##################################################################################################
+void FrameReader::clear()
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  for(auto i : d->lru)
+    d->entries.erase(i);
+  d->lru.clear();
+  d->stats.bytes = 0;
+  d->stats.count = 0;
+}
+
+//##################################################################################################
+FrameReaderStats FrameReader::stats() const
+{
+  std::vector<double> latencies;
+  FrameReaderStats stats;
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    stats = d->stats;
+    latencies = d->latencies;
+  }
+
+  if(!latencies.empty())
+  {
+    std::sort(latencies.begin(), latencies.end());
+    double total=0.0;
+    for(auto l : latencies)
+      total += l;
+
+    stats.meanLatency = total / double(latencies.size());
+    stats.p95Latency = latencies.at(((latencies.size()-1)*95)/100);
+    stats.maxLatency = latencies.back();
+  }
+
+  return stats;
+}
+
+//##################################################################################################
+void FrameReader::resetStats()
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  FrameReaderStats stats;
+  stats.bytes = d->stats.bytes;
+  stats.count = d->stats.count;
+  d->stats = stats;
+  d->latencies.clear();
+  d->latencyIndex = 0;
+}
+
+}
@@ -1,5 +1,7 @@
 #include "tp_image_utils/Globals.h"
 
+#include <string_view>
+
 namespace tp_image_utils
 {
 
@@ -18,6 +20,10 @@ std::string fileTypeToString(FileType fileType)
     case FileType::bmp         : return "bmp";
     case FileType::webp        : return "webp";
     case FileType::ico         : return "ico";
+    case FileType::qoi         : return "qoi";
+    case FileType::tga         : return "tga";
+    case FileType::pnm         : return "pnm";
+    case FileType::pfm         : return "pfm";
     case FileType::ImagesEnd   : return "Unknown";
 
     case FileType::VideosStart : return "Unknown";
@@ -39,6 +45,10 @@ FileType fileTypeFromString(const std::string& fileType)
   if(fileType == "bmp") return FileType::bmp;
   if(fileType == "webp") return FileType::webp;
   if(fileType == "ico") return FileType::ico;
+  if(fileType == "qoi") return FileType::qoi;
+  if(fileType == "tga") return FileType::tga;
+  if(fileType == "pnm" || fileType == "pgm" || fileType == "ppm") return FileType::pnm;
+  if(fileType == "pfm") return FileType::pfm;
   if(fileType == "mp4") return FileType::mp4;
 
   return FileType::Unknown;
@@ -47,31 +57,39 @@ FileType fileTypeFromString(const std::string& fileType)
 //##################################################################################################
 FileType guessImageFormat(const std::string& data, const std::string& name)
 {
-  using namespace std::string_literals;
+  return guessImageFormat(reinterpret_cast<const uint8_t*>(data.data()), data.size(), name);
+}
+
+//##################################################################################################
+FileType guessImageFormat(const uint8_t* data, size_t size, const std::string& name)
+{
+  using namespace std::string_view_literals;
+
+  std::string_view view(reinterpret_cast<const char*>(data), size);
 
-  auto startsWith = [&](const std::string& pattern)
+  auto startsWith = [&](std::string_view pattern)
   {
-    return data.rfind(pattern, 0) == 0;
+    return view.substr(0, pattern.size()) == pattern;
   };
 
-  auto compare = [&](const std::string& pattern, size_t pos)
+  auto compare = [&](std::string_view pattern, size_t pos)
   {
-    if((pos + pattern.size()) >= data.size())
+    if((pos + pattern.size()) >= view.size())
       return false;
 
-    return data.compare(pos, pattern.size(), pattern) == 0;
+    return view.compare(pos, pattern.size(), pattern) == 0;
   };
 
-  if(startsWith("\xFF\xD8\xFF"s))
+  if(startsWith("\xFF\xD8\xFF"sv))
     return FileType::jpg;
 
-  if(startsWith("\x89\x50\x4E\x47\x0D\x0A\x1A\x0A"s))
+  if(startsWith("\x89\x50\x4E\x47\x0D\x0A\x1A\x0A"sv))
     return FileType::png;
 
-  if(startsWith("GIF87a"s) || startsWith("GIF89a"s))
+  if(startsWith("GIF87a"sv) || startsWith("GIF89a"sv))
     return FileType::gif;
 
-  if(startsWith("\x49\x49\x2A\x00"s) || startsWith("\x4D\x4D\x00\x2A"s))
+  if(startsWith("\x49\x49\x2A\x00"sv) || startsWith("\x4D\x4D\x00\x2A"sv))
     return FileType::tiff;
 
   if(startsWith("BM"))
@@ -80,10 +98,26 @@ FileType guessImageFormat(const std::string& data, const std::string& name)
   if(startsWith("RIFF") || startsWith("WEBP"))
     return FileType::webp;
 
+  if(startsWith("qoif"))
+    return FileType::qoi;
+
+  // Netpbm magic numbers are always followed by whitespace.
+  auto netpbm = [&](char type)
+  {
+    return view.size()>2 && view[0]=='P' && view[1]==type && (view[2]==' ' || view[2]=='\n' || view[2]=='\r' || view[2]=='\t');
+  };
+
+  if(netpbm('5') || netpbm('6'))
+    return FileType::pnm;
+
+  if(netpbm('F') || netpbm('f'))
+    return FileType::pfm;
+
   if(compare("ftypisom", 4))
     return FileType::mp4;
 
-  if(startsWith(std::string("\x00\x00\x01\x00"s)) || startsWith("\x00\x00\x02\x00"s))
+  // Uncompressed TGA can start with the same bytes, but has a zero where ICO has the image count.
+  if((startsWith("\x00\x00\x01\x00"sv) || startsWith("\x00\x00\x02\x00"sv)) && view.size()>5 && (view[4]!=0 || view[5]!=0))
     return FileType::ico;
 
   std::vector<std::string> results;
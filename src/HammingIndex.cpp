@@ -0,0 +1,148 @@
+#include "tp_image_utils/HammingIndex.h"
+#include "tp_image_utils/PerceptualHash.h"
+
+#include <algorithm>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t nParts=4;
+constexpr size_t partBits=16;
+constexpr size_t nBuckets=size_t(1)<<partBits;
+
+// Beyond this many bits per part enumerating buckets costs more than scanning.
+constexpr int maxPartDistance=3;
+
+//##################################################################################################
+uint16_t part(uint64_t hash, size_t p)
+{
+  return uint16_t(hash>>(p*partBits));
+}
+
+//##################################################################################################
+//! Call closure with every 16 bit value within distance bits of value.
+template<typename T>
+void forEachNeighbour(uint16_t value, int distance, size_t firstBit, const T& closure)
+{
+  closure(value);
+  if(distance<1)
+    return;
+
+  for(size_t bit=firstBit; bit<partBits; bit++)
+    forEachNeighbour(uint16_t(value ^ (1u<<bit)), distance-1, bit+1, closure);
+}
+}
+
+//##################################################################################################
+struct HammingIndex::Private
+{
+  std::vector<uint64_t> hashes;
+
+  // For each part, the ids of the hashes with each value of that part.
+  std::vector<std::vector<uint32_t>> tables[nParts];
+
+  //################################################################################################
+  Private()
+  {
+    for(auto& table : tables)
+      table.resize(nBuckets);
+  }
+};
+
+//##################################################################################################
+HammingIndex::HammingIndex():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+HammingIndex::~HammingIndex()
+{
+  delete d;
+}
+
+//##################################################################################################
+size_t HammingIndex::add(uint64_t hash)
+{
+  auto id = uint32_t(d->hashes.size());
+  d->hashes.push_back(hash);
+  for(size_t p=0; p<nParts; p++)
+    d->tables[p][part(hash, p)].push_back(id);
+  return id;
+}
+
+//##################################################################################################
+void HammingIndex::add(const std::vector<uint64_t>& hashes)
+{
+  d->hashes.reserve(d->hashes.size()+hashes.size());
+  for(auto hash : hashes)
+    add(hash);
+}
+
+//##################################################################################################
+size_t HammingIndex::size() const
+{
+  return d->hashes.size();
+}
+
+//##################################################################################################
+uint64_t HammingIndex::hash(size_t id) const
+{
+  return d->hashes.at(id);
+}
+
+//##################################################################################################
+std::vector<HammingMatch> HammingIndex::find(uint64_t hash, int maxDistance) const
+{
+  std::vector<HammingMatch> matches;
+  if(maxDistance<0)
+    return matches;
+
+  // By the pigeonhole principle a match differs by at most this many bits in one of the parts.
+  int partDistance = maxDistance/int(nParts);
+
+  auto check = [&](size_t id)
+  {
+    if(int distance = hammingDistance(hash, d->hashes[id]); distance<=maxDistance)
+      matches.push_back({id, distance});
+  };
+
+  if(partDistance>maxPartDistance)
+  {
+    for(size_t id=0; id<d->hashes.size(); id++)
+      check(id);
+  }
+  else
+  {
+    for(size_t p=0; p<nParts; p++)
+    {
+      const auto& table = d->tables[p];
+      forEachNeighbour(part(hash, p), partDistance, 0, [&](uint16_t value)
+      {
+        for(auto id : table[value])
+          check(id);
+      });
+    }
+
+    // A hash that is close in several parts is found once for each of them.
+    std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b){return a.id<b.id;});
+    matches.erase(std::unique(matches.begin(), matches.end(), [](const auto& a, const auto& b){return a.id==b.id;}), matches.end());
+  }
+
+  std::stable_sort(matches.begin(), matches.end(), [](const auto& a, const auto& b){return a.distance<b.distance;});
+  return matches;
+}
+
+//##################################################################################################
+void HammingIndex::clear()
+{
+  d->hashes = std::vector<uint64_t>();
+  for(auto& table : d->tables)
+    for(auto& bucket : table)
+      bucket = std::vector<uint32_t>();
+}
+
+}
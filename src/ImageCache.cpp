@@ -0,0 +1,211 @@
+#include "tp_image_utils/ImageCache.h"
+#include "tp_image_utils/LoadImages.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <filesystem>
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct ImageCache::Private
+{
+  //################################################################################################
+  struct Entry
+  {
+    std::shared_future<ColorMap> image;
+    std::list<std::string>::iterator lru;
+    size_t bytes{0};
+    bool loaded{false};
+  };
+
+  mutable std::mutex mutex;
+  size_t maxBytes;
+
+  // Most recently used at the front, only contains entries that have finished loading.
+  std::list<std::string> lru;
+  std::unordered_map<std::string, Entry> entries;
+  ImageCacheStats stats;
+
+  //################################################################################################
+  Private(size_t maxBytes_):
+    maxBytes(maxBytes_)
+  {
+
+  }
+
+  //################################################################################################
+  //! Call with the mutex locked.
+  void evict()
+  {
+    while(stats.bytes>maxBytes && !lru.empty())
+    {
+      auto i = entries.find(lru.back());
+      stats.bytes -= i->second.bytes;
+      stats.count--;
+      stats.evictions++;
+      entries.erase(i);
+      lru.pop_back();
+    }
+  }
+
+  //################################################################################################
+  static std::string makeKey(const std::string& path, size_t targetWidth, size_t targetHeight)
+  {
+    std::error_code ec;
+    auto fileSize = std::filesystem::file_size(path, ec);
+    if(ec)
+      fileSize = 0;
+
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    auto ticks = ec?0:int64_t(mtime.time_since_epoch().count());
+
+    return path + '\0' +
+        std::to_string(fileSize) + ':' +
+        std::to_string(ticks) + ':' +
+        std::to_string(targetWidth) + 'x' + std::to_string(targetHeight);
+  }
+};
+
+//##################################################################################################
+ImageCache::ImageCache(size_t maxBytes):
+  d(new Private(maxBytes))
+{
+
+}
+
+//##################################################################################################
+ImageCache::~ImageCache()
+{
+  delete d;
+}
+
+//##################################################################################################
+ImageCache& ImageCache::instance()
+{
+  static ImageCache cache;
+  return cache;
+}
+
+//##################################################################################################
+ColorMap ImageCache::loadImage(const std::string& path, size_t targetWidth, size_t targetHeight)
+{
+  std::vector<std::string> errors;
+  ColorMap image = loadImage(path, errors, targetWidth, targetHeight);
+  for(const auto& error : errors)
+    tpWarning() << error;
+  return image;
+}
+
+//##################################################################################################
+ColorMap ImageCache::loadImage(const std::string& path,
+                               std::vector<std::string>& errors,
+                               size_t targetWidth,
+                               size_t targetHeight)
+{
+  auto key = Private::makeKey(path, targetWidth, targetHeight);
+
+  std::promise<ColorMap> promise;
+  {
+    std::unique_lock<std::mutex> lock(d->mutex);
+    if(auto i = d->entries.find(key); i!=d->entries.end())
+    {
+      d->stats.hits++;
+      auto& entry = i->second;
+      if(entry.loaded)
+        d->lru.splice(d->lru.begin(), d->lru, entry.lru);
+
+      auto image = entry.image;
+      lock.unlock();
+      return image.get();
+    }
+
+    d->stats.misses++;
+    d->entries[key].image = promise.get_future().share();
+  }
+
+  // Let the decoder reduce the resolution where it can, the result is scaled to the exact size.
+  LoadOptions options;
+  options.width = targetWidth;
+  options.height = targetHeight;
+  // The promise must always be set and the entry removed, otherwise waiters and later lookups of
+  // this key would fail for the life of the cache.
+  ColorMap image;
+  try
+  {
+    image = tp_image_utils::loadImage(path, options, errors);
+  }
+  catch(const std::exception& e)
+  {
+    errors.push_back("Failed to load image: " + path + " " + e.what());
+  }
+  catch(...)
+  {
+    errors.push_back("Failed to load image: " + path);
+  }
+
+  promise.set_value(image);
+
+  std::lock_guard<std::mutex> lock(d->mutex);
+  auto i = d->entries.find(key);
+  if(i==d->entries.end())
+    return image;
+
+  // Don't hold on to failures so that they will be retried.
+  if(image.size()<1)
+  {
+    d->entries.erase(i);
+    return image;
+  }
+
+  auto& entry = i->second;
+  entry.loaded = true;
+  entry.bytes = image.sizeInBytes();
+  d->lru.push_front(key);
+  entry.lru = d->lru.begin();
+  d->stats.bytes += entry.bytes;
+  d->stats.count++;
+  d->evict();
+
+  return image;
+}
+
+//##################################################################################################
+void ImageCache::setMaxBytes(size_t maxBytes)
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  d->maxBytes = maxBytes;
+  d->evict();
+}
+
+//##################################################################################################
+size_t ImageCache::maxBytes() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->maxBytes;
+}
+
+//##################################################################################################
+void ImageCache::clear()
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  for(const auto& key : d->lru)
+    d->entries.erase(key);
+  d->lru.clear();
+  d->stats.bytes = 0;
+  d->stats.count = 0;
+}
+
+//##################################################################################################
+ImageCacheStats ImageCache::stats() const
+{
+  std::lock_guard<std::mutex> lock(d->mutex);
+  return d->stats;
+}
+
+}
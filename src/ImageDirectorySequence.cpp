@@ -0,0 +1,339 @@
+#include "tp_image_utils/ImageDirectorySequence.h"
+#include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/LoadImages.h"
+#include "tp_image_utils/TGA.h"
+#include "tp_image_utils/MappedFile.h"
+#include "tp_image_utils/WorkerPool.h"
+
+#include "tp_utils/DebugUtils.h"
+
+#include <filesystem>
+#include <future>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+bool isDigit(char c)
+{
+  return c>='0' && c<='9';
+}
+
+//##################################################################################################
+std::string fileName(const std::string& path)
+{
+  auto i = path.find_last_of("/\\");
+  return (i==std::string::npos)?path:path.substr(i+1);
+}
+
+//##################################################################################################
+std::vector<std::string> directoryPaths(const std::string& directory)
+{
+  auto paths = imagePaths(directory);
+  std::sort(paths.begin(), paths.end(), naturalLess);
+  return paths;
+}
+
+//##################################################################################################
+std::vector<std::string> patternPaths(const std::string& pattern)
+{
+  std::string directory;
+  std::string name = pattern;
+  if(auto i = pattern.find_last_of("/\\"); i!=std::string::npos)
+  {
+    directory = pattern.substr(0, i);
+    name = pattern.substr(i+1);
+  }
+
+  std::string prefix;
+  std::string suffix;
+  size_t width=0;
+  if(!parseFramePattern(name, prefix, suffix, width))
+    return {};
+
+  std::vector<std::pair<uint64_t, std::string>> frames;
+  for(const auto& path : imagePaths(directory.empty()?std::string("."):directory))
+  {
+    auto n = fileName(path);
+    if(n.size()<=prefix.size()+suffix.size() ||
+       n.compare(0, prefix.size(), prefix)!=0 ||
+       n.compare(n.size()-suffix.size(), suffix.size(), suffix)!=0)
+      continue;
+
+    auto number = n.substr(prefix.size(), n.size()-prefix.size()-suffix.size());
+    if(number.size()<width || number.size()>19 || !std::all_of(number.begin(), number.end(), isDigit))
+      continue;
+
+    frames.emplace_back(std::stoull(number), path);
+  }
+
+  std::sort(frames.begin(), frames.end());
+
+  std::vector<std::string> paths;
+  paths.reserve(frames.size());
+  for(auto& frame : frames)
+    paths.push_back(std::move(frame.second));
+  return paths;
+}
+}
+
+//##################################################################################################
+struct ImageDirectorySequence::Private
+{
+  std::vector<std::string> paths;
+  size_t nThreads;
+
+  std::mutex mutex;
+  std::vector<ImageInfo> info;
+  std::vector<bool> hasInfo;
+  std::unique_ptr<WorkerPool> pool;
+
+  //################################################################################################
+  Private(const std::vector<std::string>& paths_, size_t nThreads_):
+    paths(paths_),
+    nThreads(nThreads_),
+    info(paths.size()),
+    hasInfo(paths.size(), false)
+  {
+
+  }
+
+  //################################################################################################
+  WorkerPool& workerPool()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!pool)
+      pool = std::make_unique<WorkerPool>(nThreads);
+    return *pool;
+  }
+
+  //################################################################################################
+  ColorMap decode(const std::string& path, std::vector<std::string>& errors)
+  {
+    // Decoders that only accept paths read the file themselves.
+    if(loadImage_ && !loadImageFromRawData_ && !loadImageFromData_)
+      return tp_image_utils::loadImage(path, errors);
+
+    auto file = MappedFile::open(path, errors);
+    if(!file)
+      return ColorMap();
+
+    // TGA has no magic number so it can only be identified by its name.
+    auto n = fileName(path);
+    if(n.size()>4 && tpToLower(n.substr(n.size()-4))==".tga")
+      return loadTGAFromData(file->data(), file->size(), errors);
+
+    return loadImageFromData(file->data(), file->size(), errors);
+  }
+};
+
+//##################################################################################################
+ImageDirectorySequence::ImageDirectorySequence(const std::vector<std::string>& paths, size_t nThreads):
+  d(new Private(paths, nThreads))
+{
+
+}
+
+//##################################################################################################
+ImageDirectorySequence::~ImageDirectorySequence()
+{
+  delete d;
+}
+
+//##################################################################################################
+ImageDirectorySequence* ImageDirectorySequence::open(const std::string& path, size_t nThreads)
+{
+  std::error_code ec;
+  auto paths = std::filesystem::is_directory(path, ec)?directoryPaths(path):patternPaths(path);
+  return paths.empty()?nullptr:new ImageDirectorySequence(paths, nThreads);
+}
+
+//##################################################################################################
+const std::vector<std::string>& ImageDirectorySequence::paths() const
+{
+  return d->paths;
+}
+
+//##################################################################################################
+ColorMap ImageDirectorySequence::loadImage(size_t i)
+{
+  if(i>=d->paths.size())
+    return ColorMap();
+
+  std::vector<std::string> errors;
+  ColorMap image = d->decode(d->paths.at(i), errors);
+  for(const auto& error : errors)
+    tpWarning() << error;
+  return image;
+}
+
+//##################################################################################################
+void ImageDirectorySequence::loadImages(size_t first,
+                                        size_t last,
+                                        size_t stride,
+                                        const std::function<bool(size_t, const ColorMap&)>& imageLoaded)
+{
+  stride = tpMax(size_t(1), stride);
+  last = tpMin(last, d->paths.size());
+  if(first>=last)
+    return;
+
+  // Keep a couple of frames per thread in flight so the threads stay busy while the callback runs,
+  // without decoding so far ahead that memory grows with the length of the range.
+  WorkerPool& pool = d->workerPool();
+  size_t window = tpMax(size_t(2), pool.nThreads()*2);
+
+  std::deque<std::pair<size_t, std::future<ColorMap>>> pending;
+  size_t next=first;
+  bool more=true;
+
+  auto submit = [&]
+  {
+    auto promise = std::make_shared<std::promise<ColorMap>>();
+    pending.emplace_back(next, promise->get_future());
+    pool.run([this, promise, i=next]{promise->set_value(loadImage(i));});
+
+    if(last-next<=stride)
+      more = false;
+    else
+      next += stride;
+  };
+
+  while(more && pending.size()<window)
+    submit();
+
+  while(!pending.empty())
+  {
+    size_t i = pending.front().first;
+    ColorMap image = pending.front().second.get();
+    pending.pop_front();
+
+    if(image.size()<1 || !imageLoaded(i, image))
+      break;
+
+    if(more)
+      submit();
+  }
+
+  // The tasks reference this sequence so wait for any that were started before we stopped.
+  for(const auto& p : pending)
+    p.second.wait();
+}
+
+//##################################################################################################
+size_t ImageDirectorySequence::frameCount()
+{
+  return d->paths.size();
+}
+
+//##################################################################################################
+bool ImageDirectorySequence::frameSize(size_t& width, size_t& height)
+{
+  ImageInfo info;
+  if(!frameInfo(0, info))
+    return AbstractImageSequence::frameSize(width, height);
+
+  width = info.width;
+  height = info.height;
+  return true;
+}
+
+//##################################################################################################
+bool ImageDirectorySequence::frameInfo(size_t i, ImageInfo& info)
+{
+  if(i>=d->paths.size())
+    return false;
+
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    if(d->hasInfo[i])
+    {
+      info = d->info[i];
+      return true;
+    }
+  }
+
+  if(!imageInfoFromFile(d->paths.at(i), info))
+    return false;
+
+  std::lock_guard<std::mutex> lock(d->mutex);
+  d->info[i] = info;
+  d->hasInfo[i] = true;
+  return true;
+}
+
+//##################################################################################################
+bool parseFramePattern(const std::string& pattern, std::string& prefix, std::string& suffix, size_t& width)
+{
+  auto p = pattern.find('%');
+  if(p==std::string::npos)
+    return false;
+
+  size_t i=p+1;
+  width = 0;
+  if(i<pattern.size() && pattern[i]=='0')
+  {
+    i++;
+    size_t digits=i;
+    for(; i<pattern.size() && isDigit(pattern[i]); i++)
+      width = width*10 + size_t(pattern[i]-'0');
+
+    if(i==digits || width>19)
+      return false;
+  }
+
+  if(i>=pattern.size() || pattern[i]!='d')
+    return false;
+
+  prefix = pattern.substr(0, p);
+  suffix = pattern.substr(i+1);
+  return suffix.find('%')==std::string::npos;
+}
+
+//##################################################################################################
+bool naturalLess(const std::string& a, const std::string& b)
+{
+  size_t i=0;
+  size_t j=0;
+  while(i<a.size() && j<b.size())
+  {
+    if(isDigit(a[i]) && isDigit(b[j]))
+    {
+      // Skip leading zeros then compare the digit runs by length and then value.
+      size_t zi=i; while(zi<a.size() && a[zi]=='0') zi++;
+      size_t zj=j; while(zj<b.size() && b[zj]=='0') zj++;
+      size_t ei=zi; while(ei<a.size() && isDigit(a[ei])) ei++;
+      size_t ej=zj; while(ej<b.size() && isDigit(b[ej])) ej++;
+
+      if(ei-zi != ej-zj)
+        return (ei-zi)<(ej-zj);
+
+      if(int c = a.compare(zi, ei-zi, b, zj, ej-zj); c!=0)
+        return c<0;
+
+      // Equal values, fewer leading zeros first.
+      if(ei-i != ej-j)
+        return (ei-i)<(ej-j);
+
+      i = ei;
+      j = ej;
+      continue;
+    }
+
+    if(a[i]!=b[j])
+      return a[i]<b[j];
+
+    i++;
+    j++;
+  }
+
+  return (a.size()-i)<(b.size()-j);
+}
+
+}
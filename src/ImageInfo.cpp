@@ -0,0 +1,481 @@
+#include "tp_image_utils/ImageInfo.h"
+#include "tp_image_utils/Netpbm.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+uint32_t be16(const uint8_t* p){return (uint32_t(p[0])<<8) | uint32_t(p[1]);}
+uint32_t le16(const uint8_t* p){return (uint32_t(p[1])<<8) | uint32_t(p[0]);}
+uint32_t le24(const uint8_t* p){return (uint32_t(p[2])<<16) | le16(p);}
+uint32_t be32(const uint8_t* p){return (be16(p)<<16) | be16(p+2);}
+uint32_t le32(const uint8_t* p){return (le16(p+2)<<16) | le16(p);}
+
+//##################################################################################################
+//! Random access to the header bytes of an image, either in memory or from a file.
+class Reader
+{
+public:
+  //################################################################################################
+  virtual ~Reader()=default;
+
+  //################################################################################################
+  //! Copy size bytes from offset into dst, returns false if the data is too short.
+  virtual bool read(size_t offset, void* dst, size_t size)=0;
+};
+
+//##################################################################################################
+class MemoryReader : public Reader
+{
+  const uint8_t* m_data;
+  size_t m_size;
+public:
+  //################################################################################################
+  MemoryReader(const uint8_t* data, size_t size):
+    m_data(data),
+    m_size(size)
+  {
+
+  }
+
+  //################################################################################################
+  bool read(size_t offset, void* dst, size_t size) override
+  {
+    if(offset>m_size || size>(m_size-offset))
+      return false;
+
+    std::memcpy(dst, m_data+offset, size);
+    return true;
+  }
+};
+
+//##################################################################################################
+//! Reads the file in small blocks, so seeking over large segments costs nothing.
+class FileReader : public Reader
+{
+  static constexpr size_t blockSize=4096;
+
+  std::ifstream m_file;
+  std::string m_block;
+  size_t m_blockOffset{0};
+public:
+  //################################################################################################
+  FileReader(const std::string& path):
+    m_file(path, std::ios::binary)
+  {
+
+  }
+
+  //################################################################################################
+  bool isOpen() const
+  {
+    return m_file.is_open();
+  }
+
+  //################################################################################################
+  bool read(size_t offset, void* dst, size_t size) override
+  {
+    if(offset<m_blockOffset || (offset+size)>(m_blockOffset+m_block.size()))
+    {
+      m_file.clear();
+      m_file.seekg(std::streamoff(offset));
+      m_block.resize(tpMax(blockSize, size));
+      m_file.read(m_block.data(), std::streamsize(m_block.size()));
+      m_block.resize(size_t(tpMax(std::streamsize(0), m_file.gcount())));
+      m_blockOffset = offset;
+
+      if(size>m_block.size())
+        return false;
+    }
+
+    std::memcpy(dst, m_block.data()+(offset-m_blockOffset), size);
+    return true;
+  }
+};
+
+//##################################################################################################
+bool pngInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[26];
+  if(!reader.read(0, h, 26) || std::memcmp(h+12, "IHDR", 4)!=0)
+    return false;
+
+  info.width  = be32(h+16);
+  info.height = be32(h+20);
+  info.bitDepth = h[24];
+
+  switch(h[25])
+  {
+    case 0: info.channels = 1; break;
+    case 2: info.channels = 3; break;
+    case 3: info.channels = 3; info.bitDepth = 8; break;
+    case 4: info.channels = 2; break;
+    case 6: info.channels = 4; break;
+    default: return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+bool jpgInfo(Reader& reader, ImageInfo& info)
+{
+  // Walk the marker segments until a start of frame is found, skipping over the contents of the
+  // others using their length field.
+  size_t pos=2;
+  for(;;)
+  {
+    uint8_t m[2];
+    if(!reader.read(pos, m, 2) || m[0]!=0xFF)
+      return false;
+
+    // Markers can be padded with any number of 0xFF fill bytes.
+    if(m[1]==0xFF)
+    {
+      pos++;
+      continue;
+    }
+
+    uint8_t marker = m[1];
+    pos+=2;
+
+    // Stand alone markers without a length.
+    if(marker==0xD8 || marker==0x01 || (marker>=0xD0 && marker<=0xD7))
+      continue;
+
+    // End of image or start of scan before any frame header.
+    if(marker==0xD9 || marker==0xDA)
+      return false;
+
+    uint8_t s[8];
+    if(!reader.read(pos, s, 2))
+      return false;
+
+    size_t length = be16(s);
+    if(length<2)
+      return false;
+
+    // SOF0-SOF15 excluding DHT, JPG, and DAC.
+    if(marker>=0xC0 && marker<=0xCF && marker!=0xC4 && marker!=0xC8 && marker!=0xCC)
+    {
+      if(!reader.read(pos, s, 8))
+        return false;
+
+      info.bitDepth = s[2];
+      info.height   = be16(s+3);
+      info.width    = be16(s+5);
+      info.channels = s[7];
+      return true;
+    }
+
+    pos+=length;
+  }
+}
+
+//##################################################################################################
+bool gifInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[10];
+  if(!reader.read(0, h, 10))
+    return false;
+
+  info.width  = le16(h+6);
+  info.height = le16(h+8);
+  info.channels = 3;
+  info.bitDepth = 8;
+  return true;
+}
+
+//##################################################################################################
+bool tiffInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[8];
+  if(!reader.read(0, h, 8))
+    return false;
+
+  bool le = (h[0]=='I');
+  auto u16 = [le](const uint8_t* p){return le?le16(p):be16(p);};
+  auto u32 = [le](const uint8_t* p){return le?le32(p):be32(p);};
+
+  size_t ifd = u32(h+4);
+
+  uint8_t c[2];
+  if(!reader.read(ifd, c, 2))
+    return false;
+
+  size_t bitsPerSample=1;
+  size_t samplesPerPixel=1;
+  bool palette=false;
+
+  size_t count = tpMin(size_t(u16(c)), size_t(1024));
+  for(size_t i=0; i<count; i++)
+  {
+    uint8_t e[12];
+    if(!reader.read(ifd+2+(i*12), e, 12))
+      return false;
+
+    uint32_t tag  = u16(e);
+    uint32_t type = u16(e+2);
+    uint32_t n    = u32(e+4);
+
+    // Values that fit in 4 bytes are stored in the entry, SHORT values are left aligned.
+    uint32_t value = (type==3)?u16(e+8):u32(e+8);
+
+    switch(tag)
+    {
+      case 256: info.width  = value; break;
+      case 257: info.height = value; break;
+      case 258:
+      {
+        // Multiple samples don't fit in the entry so read the first from the offset.
+        if(n>2 && type==3)
+        {
+          uint8_t b[2];
+          if(!reader.read(u32(e+8), b, 2))
+            return false;
+          value = u16(b);
+        }
+        bitsPerSample = value;
+        break;
+      }
+      case 262: palette = (value==3); break;
+      case 277: samplesPerPixel = value; break;
+      default: break;
+    }
+  }
+
+  info.channels = palette?3:samplesPerPixel;
+  info.bitDepth = palette?8:bitsPerSample;
+  return true;
+}
+
+//##################################################################################################
+bool bmpInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[30];
+  if(!reader.read(0, h, 26))
+    return false;
+
+  size_t bitsPerPixel;
+  if(le32(h+14) == 12)
+  {
+    info.width  = le16(h+18);
+    info.height = le16(h+20);
+    bitsPerPixel = le16(h+24);
+  }
+  else
+  {
+    if(!reader.read(0, h, 30))
+      return false;
+
+    auto height = int32_t(le32(h+22));
+    info.width  = size_t(int32_t(le32(h+18)));
+    info.height = size_t((height<0)?-int64_t(height):int64_t(height));
+    bitsPerPixel = le16(h+28);
+  }
+
+  info.channels = (bitsPerPixel==32)?4:3;
+  info.bitDepth = (bitsPerPixel==16)?5:8;
+  return true;
+}
+
+//##################################################################################################
+bool webpInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[30];
+  if(!reader.read(0, h, 21) || std::memcmp(h, "RIFF", 4)!=0 || std::memcmp(h+8, "WEBP", 4)!=0)
+    return false;
+
+  info.bitDepth = 8;
+
+  if(std::memcmp(h+12, "VP8 ", 4)==0)
+  {
+    // Lossy, a 3 byte frame tag is followed by the start code and 14 bit dimensions.
+    if(!reader.read(0, h, 30) || h[23]!=0x9D || h[24]!=0x01 || h[25]!=0x2A)
+      return false;
+
+    info.width  = le16(h+26) & 0x3FFF;
+    info.height = le16(h+28) & 0x3FFF;
+    info.channels = 3;
+    return true;
+  }
+
+  if(std::memcmp(h+12, "VP8L", 4)==0)
+  {
+    // Lossless, a signature byte is followed by 14 bit width-1, 14 bit height-1, and alpha flag.
+    if(!reader.read(0, h, 25) || h[20]!=0x2F)
+      return false;
+
+    uint32_t bits = le32(h+21);
+    info.width  = (bits & 0x3FFF) + 1;
+    info.height = ((bits>>14) & 0x3FFF) + 1;
+    info.channels = ((bits>>28) & 1)?4:3;
+    return true;
+  }
+
+  if(std::memcmp(h+12, "VP8X", 4)==0)
+  {
+    // Extended, flags are followed by 24 bit canvas width-1 and height-1.
+    if(!reader.read(0, h, 30))
+      return false;
+
+    info.width  = le24(h+24) + 1;
+    info.height = le24(h+27) + 1;
+    info.channels = (h[20] & 0x10)?4:3;
+    return true;
+  }
+
+  return false;
+}
+
+//##################################################################################################
+bool icoInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[6];
+  if(!reader.read(0, h, 6))
+    return false;
+
+  // Report the largest image in the directory, a size of 0 means 256.
+  size_t count = le16(h+4);
+  for(size_t i=0; i<count; i++)
+  {
+    uint8_t e[16];
+    if(!reader.read(6+(i*16), e, 16))
+      break;
+
+    size_t w = (e[0]==0)?256:e[0];
+    size_t ht = (e[1]==0)?256:e[1];
+    if(w*ht <= info.width*info.height)
+      continue;
+
+    size_t bitsPerPixel = le16(e+6);
+    info.width  = w;
+    info.height = ht;
+    info.channels = (bitsPerPixel==32 || bitsPerPixel==0)?4:3;
+    info.bitDepth = 8;
+  }
+
+  return count>0;
+}
+
+//##################################################################################################
+bool qoiInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[14];
+  if(!reader.read(0, h, 14))
+    return false;
+
+  info.width  = be32(h+4);
+  info.height = be32(h+8);
+  info.channels = h[12];
+  info.bitDepth = 8;
+  return true;
+}
+
+//##################################################################################################
+bool tgaInfo(Reader& reader, ImageInfo& info)
+{
+  uint8_t h[18];
+  if(!reader.read(0, h, 18))
+    return false;
+
+  info.width  = le16(h+12);
+  info.height = le16(h+14);
+  info.channels = (h[16]==8)?1:((h[16]==32)?4:3);
+  info.bitDepth = 8;
+  return true;
+}
+
+//##################################################################################################
+bool netpbmInfo(Reader& reader, ImageInfo& info)
+{
+  // Headers are text of variable length, comments aside they fit easily in this.
+  uint8_t h[256];
+  size_t size=0;
+  while(size<sizeof(h) && reader.read(size, h+size, 1))
+    size++;
+
+  std::vector<std::string> errors;
+  NetpbmHeader header;
+  if(!readNetpbmHeader(h, size, header, errors))
+    return false;
+
+  info.width  = header.width;
+  info.height = header.height;
+  info.channels = (header.type=='6' || header.type=='F')?3:1;
+  info.bitDepth = (header.maxValue>255)?16:((header.scale!=0.0f)?32:8);
+  return true;
+}
+
+//##################################################################################################
+bool imageInfo(Reader& reader, const std::string& name, ImageInfo& info)
+{
+  info = ImageInfo();
+
+  std::string head;
+  head.resize(16);
+  for(size_t s=head.size(); s>0; s--)
+  {
+    if(reader.read(0, head.data(), s))
+    {
+      head.resize(s);
+      break;
+    }
+  }
+
+  info.fileType = guessImageFormat(reinterpret_cast<const uint8_t*>(head.data()), head.size(), name);
+
+  bool ok=false;
+  switch(info.fileType)
+  {
+    case FileType::jpg : ok = jpgInfo (reader, info); break;
+    case FileType::png : ok = pngInfo (reader, info); break;
+    case FileType::gif : ok = gifInfo (reader, info); break;
+    case FileType::tiff: ok = tiffInfo(reader, info); break;
+    case FileType::bmp : ok = bmpInfo (reader, info); break;
+    case FileType::webp: ok = webpInfo(reader, info); break;
+    case FileType::ico : ok = icoInfo (reader, info); break;
+    case FileType::qoi : ok = qoiInfo (reader, info); break;
+    case FileType::tga : ok = tgaInfo (reader, info); break;
+    case FileType::pnm : ok = netpbmInfo(reader, info); break;
+    case FileType::pfm : ok = netpbmInfo(reader, info); break;
+    default: break;
+  }
+
+  return ok && info.width>0 && info.height>0;
+}
+}
+
+//##################################################################################################
+bool imageInfo(const std::string& data, ImageInfo& info)
+{
+  return imageInfo(reinterpret_cast<const uint8_t*>(data.data()), data.size(), info);
+}
+
+//##################################################################################################
+bool imageInfo(const uint8_t* data, size_t size, ImageInfo& info)
+{
+  MemoryReader reader(data, size);
+  return imageInfo(reader, std::string(), info);
+}
+
+//##################################################################################################
+bool imageInfoFromFile(const std::string& path, ImageInfo& info)
+{
+  FileReader reader(path);
+  if(!reader.isOpen())
+  {
+    info = ImageInfo();
+    return false;
+  }
+
+  return imageInfo(reader, path, info);
+}
+
+}
@@ -0,0 +1,294 @@
+#include "tp_image_utils/ImagePaths.h"
+#include "tp_image_utils/LoadImages.h"
+#include "tp_image_utils/WorkerPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <set>
+
+#if defined(TP_LINUX) || defined(TP_OSX)
+#define TP_IMAGE_UTILS_POSIX_DIRECTORIES
+#include <dirent.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+//! Returns true if the name ends with one of the image extensions, without allocating.
+bool hasImageExtension(const char* name, size_t length)
+{
+  const char* dot = nullptr;
+  for(const char* c=name+length; c>name; c--)
+  {
+    if(*(c-1)=='.')
+    {
+      dot = c-1;
+      break;
+    }
+  }
+
+  if(!dot)
+    return false;
+
+  // Longer than any image extension.
+  size_t n = size_t((name+length)-dot);
+  if(n>8)
+    return false;
+
+  char lower[8];
+  for(size_t i=0; i<n; i++)
+  {
+    char c = dot[i];
+    lower[i] = (c>='A' && c<='Z')?char(c-'A'+'a'):c;
+  }
+
+  // Small string optimization means this does not allocate.
+  return imageExtensionsSet().count(std::string(lower, n))!=0;
+}
+
+//##################################################################################################
+std::string join(const std::string& directory, const char* name)
+{
+  return (!directory.empty() && directory.back()=='/')?(directory + name):(directory + '/' + name);
+}
+
+//##################################################################################################
+bool sniffImage(const std::string& path)
+{
+  uint8_t header[16];
+  size_t size=0;
+
+#ifdef TP_IMAGE_UTILS_POSIX_DIRECTORIES
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd<0)
+    return false;
+
+  ssize_t r = ::read(fd, header, sizeof(header));
+  ::close(fd);
+  if(r>0)
+    size = size_t(r);
+#else
+  std::ifstream in(path, std::ios::binary);
+  in.read(reinterpret_cast<char*>(header), sizeof(header));
+  size = size_t(in.gcount());
+#endif
+
+  if(size<1)
+    return false;
+
+  // Pass no name so that only the magic number is used.
+  FileType fileType = guessImageFormat(header, size, std::string());
+  if(isImage(fileType))
+    return true;
+
+  // TGA has no magic number.
+  if(fileType!=FileType::Unknown)
+    return false;
+
+  auto dot = path.find_last_of('.');
+  return dot!=std::string::npos && tpToLower(path.substr(dot))==".tga";
+}
+
+//##################################################################################################
+struct Scanner
+{
+  const ImagePathsOptions& options;
+  std::vector<std::string>& errors;
+
+  std::mutex mutex;
+  std::vector<std::string> paths;
+  WorkerPool* pool{nullptr};
+
+#ifdef TP_IMAGE_UTILS_POSIX_DIRECTORIES
+  // Directories already listed, to break symlink loops when following symlinks.
+  std::set<std::pair<dev_t, ino_t>> visited;
+#endif
+
+  //################################################################################################
+  Scanner(const ImagePathsOptions& options_, std::vector<std::string>& errors_):
+    options(options_),
+    errors(errors_)
+  {
+
+  }
+
+  //################################################################################################
+  void addResults(std::vector<std::string>& found, std::vector<std::string>& failed)
+  {
+    if(found.empty() && failed.empty())
+      return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    paths.insert(paths.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+    errors.insert(errors.end(), failed.begin(), failed.end());
+  }
+
+  //################################################################################################
+  void scanDirectory(const std::string& directory)
+  {
+    std::vector<std::string> found;
+    std::vector<std::string> failed;
+    std::vector<std::string> subDirectories;
+
+#ifdef TP_IMAGE_UTILS_POSIX_DIRECTORIES
+    DIR* dir = opendir(directory.c_str());
+    if(!dir)
+    {
+      failed.push_back("Failed to open directory: " + directory);
+      addResults(found, failed);
+      return;
+    }
+
+    if(options.followSymlinks)
+    {
+      struct stat s;
+      if(fstat(dirfd(dir), &s)==0)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(!visited.emplace(s.st_dev, s.st_ino).second)
+        {
+          closedir(dir);
+          return;
+        }
+      }
+    }
+
+    while(dirent* entry = readdir(dir))
+    {
+      const char* name = entry->d_name;
+      if(name[0]=='.' && (name[1]==0 || (name[1]=='.' && name[2]==0)))
+        continue;
+
+      unsigned char type = entry->d_type;
+      bool isDirectory = type==DT_DIR;
+      bool isFile = type==DT_REG;
+
+      // When the file system does not report the type, find out if it is a link first so that links
+      // to directories are not followed unless asked.
+      if(type==DT_UNKNOWN && !options.followSymlinks)
+      {
+        struct stat s;
+        if(fstatat(dirfd(dir), name, &s, AT_SYMLINK_NOFOLLOW)==0)
+        {
+          if(S_ISLNK(s.st_mode))
+            type = DT_LNK;
+          else
+          {
+            isDirectory = S_ISDIR(s.st_mode);
+            isFile = S_ISREG(s.st_mode);
+          }
+        }
+      }
+
+      // Only stat when the file system does not report the type, or to resolve links.
+      if((type==DT_UNKNOWN && options.followSymlinks) || (type==DT_LNK && (options.followSymlinks || hasImageExtension(name, strlen(name)))))
+      {
+        struct stat s;
+        if(fstatat(dirfd(dir), name, &s, 0)==0)
+        {
+          isDirectory = S_ISDIR(s.st_mode) && (type!=DT_LNK || options.followSymlinks);
+          isFile = S_ISREG(s.st_mode);
+        }
+      }
+
+      if(isDirectory)
+      {
+        if(options.recursive)
+          subDirectories.push_back(join(directory, name));
+      }
+      else if(isFile && hasImageExtension(name, strlen(name)))
+        found.push_back(join(directory, name));
+    }
+
+    closedir(dir);
+#else
+    std::error_code ec;
+    std::filesystem::directory_iterator i(directory, ec);
+    if(ec)
+    {
+      failed.push_back("Failed to open directory: " + directory);
+      addResults(found, failed);
+      return;
+    }
+
+    for(const auto& entry : i)
+    {
+      auto name = entry.path().filename().string();
+      if(entry.is_directory(ec))
+      {
+        if(options.recursive && (options.followSymlinks || !entry.is_symlink(ec)))
+          subDirectories.push_back(entry.path().string());
+      }
+      else if(entry.is_regular_file(ec) && hasImageExtension(name.data(), name.size()))
+        found.push_back(entry.path().string());
+    }
+#endif
+
+    if(options.sniff)
+      found.erase(std::remove_if(found.begin(), found.end(), [](const auto& path){return !sniffImage(path);}), found.end());
+
+    addResults(found, failed);
+
+    for(const auto& subDirectory : subDirectories)
+    {
+      if(pool)
+        pool->run([this, subDirectory]{scanDirectory(subDirectory);});
+      else
+        scanDirectory(subDirectory);
+    }
+  }
+};
+}
+
+//##################################################################################################
+std::vector<std::string> scanImagePaths(const std::string& directory,
+                                        const ImagePathsOptions& options,
+                                        std::vector<std::string>& errors)
+{
+  std::error_code ec;
+  std::string root = std::filesystem::absolute(directory, ec).lexically_normal().string();
+  if(ec)
+    root = directory;
+  while(root.size()>1 && (root.back()=='/' || root.back()=='\\'))
+    root.pop_back();
+
+  Scanner scanner(options, errors);
+
+  if(options.recursive && options.nThreads!=1)
+  {
+    WorkerPool pool(options.nThreads);
+    scanner.pool = &pool;
+    pool.run([&]{scanner.scanDirectory(root);});
+    pool.waitForIdle();
+  }
+  else
+    scanner.scanDirectory(root);
+
+  std::sort(scanner.paths.begin(), scanner.paths.end());
+  return std::move(scanner.paths);
+}
+
+//##################################################################################################
+const std::unordered_set<std::string>& imageExtensionsSet()
+{
+  static const std::unordered_set<std::string> extensions = []
+  {
+    std::unordered_set<std::string> extensions;
+    for(const auto& type : imageTypes())
+      extensions.insert(tpToLower(type.substr(1)));
+    return extensions;
+  }();
+  return extensions;
+}
+
+}
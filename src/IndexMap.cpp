@@ -175,4 +175,23 @@ void IndexMap::setSize(size_t width, size_t height)
   m_data.resize(width*height);
 }
 
+//##################################################################################################
+uint64_t IndexMap::contentHash() const
+{
+  return contentHash128().low;
+}
+
+//##################################################################################################
+Hash128 IndexMap::contentHash128() const
+{
+  return imageContentHash128(m_data.data(), m_width, m_height, sizeof(uint32_t));
+}
+
+//##################################################################################################
+bool IndexMap::contentEquals(const IndexMap& other) const
+{
+  return m_width==other.m_width && m_height==other.m_height &&
+      tp_image_utils::contentEquals(m_data.data(), other.m_data.data(), m_data.size()*sizeof(uint32_t));
+}
+
 }
@@ -1,17 +1,35 @@
 #include "tp_image_utils/LoadImages.h"
 #include "tp_image_utils/Scale.h"
+#include "tp_image_utils/QOI.h"
+#include "tp_image_utils/BMP.h"
+#include "tp_image_utils/TGA.h"
+#include "tp_image_utils/Netpbm.h"
+#include "tp_image_utils/ToFloat.h"
+#include "tp_image_utils/Base64.h"
+#include "tp_image_utils/RLE.h"
+#include "tp_image_utils/MappedFile.h"
+#include "tp_image_utils/ImagePaths.h"
+#include "tp_image_utils/Exif.h"
 
 #include "tp_utils/JSONUtils.h"
 #include "tp_utils/Resources.h"
 #include "tp_utils/DebugUtils.h"
+#include "tp_utils/FileUtils.h"
+#include "tp_utils/Parallel.h"
 
-#include "base64.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
 
 namespace tp_image_utils
 {
 
 ColorMap (*loadImage_)(const std::string& path, std::vector<std::string>& errors) = nullptr;
 ColorMap (*loadImageFromData_)(const std::string& data, std::vector<std::string>& errors) = nullptr;
+ColorMap (*loadImageFromRawData_)(const uint8_t* data, size_t size, std::vector<std::string>& errors) = nullptr;
+ColorMap (*loadImageWithOptions_)(const std::string& path, const LoadOptions& options, std::vector<std::string>& errors) = nullptr;
+ColorMap (*loadImageFromDataWithOptions_)(const uint8_t* data, size_t size, const LoadOptions& options, std::vector<std::string>& errors) = nullptr;
+bool (*loadImageRowsFromData_)(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors) = nullptr;
 std::vector<std::string> (*imagePaths_)(const std::string& path) = nullptr;
 std::vector<ColorMap> (*loadImages_)(const std::string& path, std::vector<std::string>& names, int64_t maxBytes) = nullptr;
 std::vector<std::string> (*getImagePaths_)(const std::string& directory) = nullptr;
@@ -30,6 +48,162 @@ struct PrintErrors
     tpWarning() << error;
   }
 };
+
+//##################################################################################################
+//! Formats that are always decoded by the built in codecs, installed hooks rarely support them.
+bool isNative(const uint8_t* data, size_t size)
+{
+  switch(guessImageFormat(data, tpMin(size, size_t(16)), std::string()))
+  {
+    case FileType::qoi:
+    case FileType::pnm:
+    case FileType::pfm:
+    return true;
+
+    default:
+    return false;
+  }
+}
+
+//##################################################################################################
+std::string extension(const std::string& path)
+{
+  auto i = path.find_last_of("./\\");
+  return (i==std::string::npos || path[i]!='.')?std::string():tpToLower(path.substr(i));
+}
+
+//##################################################################################################
+bool isNativePath(const std::string& path)
+{
+  auto e = extension(path);
+  return e==".qoi" || e==".tga" || e==".pgm" || e==".ppm" || e==".pnm" || e==".pfm";
+}
+
+//##################################################################################################
+//! The options to decode with so that the result has the requested size once it is oriented.
+LoadOptions decodeOptions(const LoadOptions& options, int orientation)
+{
+  LoadOptions o = options;
+  o.applyOrientation = false;
+  if(orientationSwapsAxes(orientation))
+    std::swap(o.width, o.height);
+  return o;
+}
+
+//##################################################################################################
+//! Scale an image returned by a decoder to exactly the size requested in options.
+ColorMap finishScale(const ColorMap& image, const LoadOptions& options)
+{
+  if(image.width()<1 || image.height()<1 || (image.width()==options.width && image.height()==options.height))
+    return image;
+
+  return scale(image, options.width, options.height, options.scaleMode);
+}
+
+//##################################################################################################
+//! Decode the data written by saveImageToJson or saveByteMapToJson straight into the image.
+template<typename T>
+T loadBytesFromJson(const nlohmann::json& j, size_t bytesPerPixel, std::vector<std::string>& errors)
+{
+  auto w = TPJSONSizeT(j, "w");
+  auto h = TPJSONSizeT(j, "h");
+
+  if(w<1 || h<1)
+  {
+    errors.push_back("Error with image size, w: " + std::to_string(w) + " h: " + std::to_string(h));
+    return T();
+  }
+
+  size_t bytes = w * h * bytesPerPixel;
+
+  auto i = j.find("data");
+  if(i!=j.end() && i->is_binary())
+  {
+    const auto& binary = i->get_binary();
+    if(binary.size() != bytes)
+    {
+      errors.push_back("Size mismatch, decoded: " + std::to_string(binary.size()) + " expected: " + std::to_string(bytes));
+      return T();
+    }
+
+    T image(w, h);
+    std::memcpy(image.data(), binary.data(), bytes);
+    return image;
+  }
+
+  if(i==j.end() || !i->is_string())
+  {
+    errors.push_back("Image data missing.");
+    return T();
+  }
+
+  const auto& data = i->template get_ref<const std::string&>();
+  size_t decodedSize = base64DecodedSize(data.data(), data.size());
+  if(decodedSize != bytes)
+  {
+    errors.push_back("Size mismatch, decoded: " + std::to_string(decodedSize) + " expected: " + std::to_string(bytes));
+    return T();
+  }
+
+  T image(w, h);
+  if(!base64Decode(data.data(), data.size(), reinterpret_cast<uint8_t*>(image.data())))
+  {
+    errors.push_back("Invalid base64 image data.");
+    return T();
+  }
+
+  return image;
+}
+
+//##################################################################################################
+//! Decode paths on worker threads, stops once the decoded images exceed maxBytes.
+void loadImagesParallel(const std::vector<std::string>& paths,
+                        int64_t maxBytes,
+                        const std::function<void(size_t, const ColorMap&)>& imageLoaded)
+{
+  std::atomic<size_t> nextPath{0};
+  std::atomic<int64_t> remainingBytes{maxBytes};
+  std::atomic_bool stop{false};
+
+  std::mutex mutex;
+  PrintErrors e;
+
+  tp_utils::parallel([&](auto /*locker*/)
+  {
+    std::vector<std::string> errors;
+
+    while(!stop)
+    {
+      size_t i = nextPath++;
+      if(i>=paths.size())
+        break;
+
+      const auto& path = paths.at(i);
+
+      ColorMap image;
+      if(loadImageFromData_ || loadImageFromRawData_)
+        image = loadImageFromData(tp_utils::readBinaryFile(path), errors);
+      else
+        image = loadImage(path, errors);
+
+      if(image.size()<1)
+        continue;
+
+      auto bytes = int64_t(image.sizeInBytes());
+      if(remainingBytes.fetch_sub(bytes) < bytes)
+      {
+        stop = true;
+        break;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      imageLoaded(i, image);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    e.errors.insert(e.errors.end(), errors.begin(), errors.end());
+  });
+}
 }
 
 //##################################################################################################
@@ -42,7 +216,51 @@ ColorMap loadImage(const std::string& path)
 //##################################################################################################
 ColorMap loadImage(const std::string& path, std::vector<std::string>& errors)
 {
-  return (loadImage_)?loadImage_(path, errors):ColorMap();
+  if(loadImage_ && !isNativePath(path))
+    return loadImage_(path, errors);
+
+  auto data = tp_utils::readBinaryFile(path);
+  if(data.empty())
+  {
+    errors.push_back("Failed to read image: " + path);
+    return ColorMap();
+  }
+
+  // TGA has no magic number so it can only be identified by its name.
+  if(extension(path)==".tga")
+    return loadTGAFromData(reinterpret_cast<const uint8_t*>(data.data()), data.size(), errors);
+
+  return loadImageFromData(data, errors);
+}
+
+//##################################################################################################
+ColorMap loadImage(const std::string& path, const LoadOptions& options, std::vector<std::string>& errors)
+{
+  if(options.applyOrientation)
+  {
+    ExifInfo exif;
+    readExifFromFile(path, exif);
+    return applyOrientation(loadImage(path, decodeOptions(options, exif.orientation), errors), exif.orientation);
+  }
+
+  if(!options.hasTarget())
+    return loadImage(path, errors);
+
+  if(loadImageWithOptions_ && !isNativePath(path))
+    return finishScale(loadImageWithOptions_(path, options, errors), options);
+
+  if(loadImage_ && !isNativePath(path) && !loadImageFromDataWithOptions_)
+    return finishScale(loadImage_(path, errors), options);
+
+  auto file = MappedFile::open(path, errors);
+  if(!file)
+    return ColorMap();
+
+  // TGA has no magic number so it can only be identified by its name.
+  if(extension(path)==".tga")
+    return finishScale(loadTGAFromData(file->data(), file->size(), errors), options);
+
+  return loadImageFromData(file->data(), file->size(), options, errors);
 }
 
 //##################################################################################################
@@ -55,7 +273,124 @@ ColorMap loadImageFromData(const std::string& data)
 //##################################################################################################
 ColorMap loadImageFromData(const std::string& data, std::vector<std::string>& errors)
 {
-  return (loadImageFromData_)?loadImageFromData_(data, errors):ColorMap();
+  auto d = reinterpret_cast<const uint8_t*>(data.data());
+
+  if(loadImageFromData_ && !isNative(d, data.size()))
+    return loadImageFromData_(data, errors);
+
+  return loadImageFromData(d, data.size(), errors);
+}
+
+//##################################################################################################
+ColorMap loadImageFromData(const uint8_t* data, size_t size)
+{
+  PrintErrors e;
+  return loadImageFromData(data, size, e.errors);
+}
+
+//##################################################################################################
+ColorMap loadImageFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  FileType fileType = guessImageFormat(data, tpMin(size, size_t(16)), std::string());
+  switch(fileType)
+  {
+    case FileType::qoi: return loadQOIFromData(data, size, errors);
+    case FileType::pnm: return loadPPMFromData(data, size, errors);
+    case FileType::pfm: return fromFloat(loadPFMFromData(data, size, errors));
+    default: break;
+  }
+
+  if(loadImageFromRawData_)
+    return loadImageFromRawData_(data, size, errors);
+
+  // Older hooks need the data in a string.
+  if(loadImageFromData_)
+    return loadImageFromData_(std::string(reinterpret_cast<const char*>(data), size), errors);
+
+  if(fileType==FileType::bmp)
+    return loadBMPFromData(data, size, errors);
+
+  // TGA has no magic number, so only try it for unrecognized data with a plausible header.
+  if(fileType==FileType::Unknown && isTGAHeader(data, size))
+    return loadTGAFromData(data, size, errors);
+
+  errors.push_back("No codec installed to load: " + fileTypeToString(fileType));
+  return ColorMap();
+}
+
+//##################################################################################################
+ColorMap loadImageFromData(const uint8_t* data, size_t size, const LoadOptions& options, std::vector<std::string>& errors)
+{
+  if(options.applyOrientation)
+  {
+    ExifInfo exif;
+    readExif(data, size, exif);
+    return applyOrientation(loadImageFromData(data, size, decodeOptions(options, exif.orientation), errors), exif.orientation);
+  }
+
+  if(!options.hasTarget())
+    return loadImageFromData(data, size, errors);
+
+  if(!isNative(data, size) && loadImageFromDataWithOptions_)
+    return finishScale(loadImageFromDataWithOptions_(data, size, options, errors), options);
+
+  // The built in codecs can scale while they decode.
+  if(options.scaleMode==ScaleMode::Stretch && (isNative(data, size) || !(loadImageFromRawData_ || loadImageFromData_ || loadImageRowsFromData_)))
+    return loadScaledImageFromData(data, size, options.width, options.height, errors);
+
+  return finishScale(loadImageFromData(data, size, errors), options);
+}
+
+//##################################################################################################
+bool loadImageRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors)
+{
+  FileType fileType = guessImageFormat(data, tpMin(size, size_t(16)), std::string());
+  switch(fileType)
+  {
+    case FileType::qoi: return loadQOIRowsFromData(data, size, sink, errors);
+    case FileType::pnm: return loadPPMRowsFromData(data, size, sink, errors);
+    default: break;
+  }
+
+  if(loadImageRowsFromData_)
+    return loadImageRowsFromData_(data, size, sink, errors);
+
+  if(fileType==FileType::bmp && !loadImageFromRawData_ && !loadImageFromData_)
+    return loadBMPRowsFromData(data, size, sink, errors);
+
+  ColorMap image = loadImageFromData(data, size, errors);
+  if(image.width()<1 || image.height()<1 || !sink.begin(image.width(), image.height()))
+    return false;
+
+  const TPPixel* s = image.constData();
+  for(size_t y=0; y<image.height(); y++, s+=image.width())
+  {
+    std::memcpy(sink.row(y), s, image.width()*sizeof(TPPixel));
+    if(!sink.rowComplete(y))
+      return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+ColorMap loadScaledImageFromData(const uint8_t* data, size_t size, size_t width, size_t height, std::vector<std::string>& errors)
+{
+  ScaleRowSink sink(width, height);
+  if(!loadImageRowsFromData(data, size, sink, errors))
+    return ColorMap();
+
+  return sink.takeImage();
+}
+
+//##################################################################################################
+ColorMap loadScaledImage(const std::string& path, size_t width, size_t height, std::vector<std::string>& errors)
+{
+  auto file = MappedFile::open(path, errors);
+  if(!file)
+    return ColorMap();
+
+  return loadScaledImageFromData(file->data(), file->size(), width, height, errors);
 }
 
 //##################################################################################################
@@ -71,7 +406,7 @@ ColorMap loadImageFromResource(const std::string& path, std::vector<std::string>
   auto res = tp_utils::resource(path);
 
   if(res.data)
-    return loadImageFromData(std::string(res.data, res.size), errors);
+    return loadImageFromData(reinterpret_cast<const uint8_t*>(res.data), res.size, errors);
 
   errors.push_back("Failed to find resource: " + path);
   return ColorMap();
@@ -80,7 +415,11 @@ ColorMap loadImageFromResource(const std::string& path, std::vector<std::string>
 //##################################################################################################
 std::vector<std::string> imagePaths(const std::string& directory)
 {
-  return (imagePaths_)?imagePaths_(directory):std::vector<std::string>();
+  if(imagePaths_)
+    return imagePaths_(directory);
+
+  PrintErrors e;
+  return scanImagePaths(directory, ImagePathsOptions(), e.errors);
 }
 
 //##################################################################################################
@@ -93,7 +432,42 @@ std::vector<ColorMap> loadImages(const std::string& path, int64_t maxBytes)
 //##################################################################################################
 std::vector<ColorMap> loadImages(const std::string& path, std::vector<std::string>& names, int64_t maxBytes)
 {
-  return (loadImages_)?loadImages_(path, names, maxBytes):std::vector<ColorMap>();
+  if(loadImages_)
+    return loadImages_(path, names, maxBytes);
+
+  auto paths = imagePaths(path);
+
+  // Collect in slots so that the results keep the order of the paths.
+  std::vector<ColorMap> slots(paths.size());
+  loadImagesParallel(paths, maxBytes, [&](size_t i, const ColorMap& image)
+  {
+    slots[i] = image;
+  });
+
+  std::vector<ColorMap> images;
+  images.reserve(slots.size());
+  for(size_t i=0; i<slots.size(); i++)
+  {
+    if(slots[i].size()<1)
+      continue;
+
+    names.push_back(paths.at(i));
+    images.push_back(std::move(slots[i]));
+  }
+
+  return images;
+}
+
+//##################################################################################################
+void loadImages(const std::string& path,
+                const std::function<void(const std::string& name, const ColorMap& image)>& imageLoaded,
+                int64_t maxBytes)
+{
+  auto paths = imagePaths(path);
+  loadImagesParallel(paths, maxBytes, [&](size_t i, const ColorMap& image)
+  {
+    imageLoaded(paths.at(i), image);
+  });
 }
 
 //##################################################################################################
@@ -106,29 +480,7 @@ ColorMap loadImageFromJson(const nlohmann::json& j)
 //##################################################################################################
 ColorMap loadImageFromJson(const nlohmann::json& j, std::vector<std::string>& errors)
 {
-  auto w = TPJSONSizeT(j, "w");
-  auto h = TPJSONSizeT(j, "h");
-  auto data = TPJSONString(j, "data");
-
-  if(w<1 || h<1)
-  {
-    errors.push_back("Error with image size, w: " + std::to_string(w) + " h: " + std::to_string(h));
-    return ColorMap();
-  }
-
-  std::string decoded = base64_decode(data);
-
-  size_t bytes = w * h * 4;
-
-  if(decoded.size() != bytes)
-  {
-    errors.push_back("Size mismatch, decoded: " + std::to_string(decoded.size()) + " expected: " + std::to_string(bytes));
-    return ColorMap();
-  }
-
-  ColorMap image(w, h);
-  memcpy(image.data(), decoded.data(), bytes);
-  return image;
+  return loadBytesFromJson<ColorMap>(j, 4, errors);
 }
 
 //##################################################################################################
@@ -141,29 +493,10 @@ ByteMap loadByteMapFromJson(const nlohmann::json& j)
 //##################################################################################################
 ByteMap loadByteMapFromJson(const nlohmann::json& j, std::vector<std::string>& errors)
 {
-  auto w = TPJSONSizeT(j, "w");
-  auto h = TPJSONSizeT(j, "h");
-  auto data = TPJSONString(j, "data");
-
-  if(w<1 || h<1)
-  {
-    errors.push_back("Error with image size, w: " + std::to_string(w) + " h: " + std::to_string(h));
-    return ByteMap();
-  }
-
-  std::string decoded = base64_decode(data);
-
-  size_t bytes = w * h;
-
-  if(decoded.size() != bytes)
-  {
-    errors.push_back("Size mismatch, decoded: " + std::to_string(decoded.size()) + " expected: " + std::to_string(bytes));
-    return ByteMap();
-  }
+  if(j.contains("rle"))
+    return loadByteMapFromRLEJson(j, errors);
 
-  ByteMap image(w, h);
-  memcpy(image.data(), decoded.data(), bytes);
-  return image;
+  return loadBytesFromJson<ByteMap>(j, 1, errors);
 }
 
 //##################################################################################################
@@ -176,16 +509,25 @@ ColorMapF loadColorMapFFromData(const std::string& data)
 //##################################################################################################
 ColorMapF loadColorMapFFromData(const std::string& data, std::vector<std::string>& errors)
 {
+  return loadColorMapFFromData(reinterpret_cast<const uint8_t*>(data.data()), data.size(), errors);
+}
+
+//##################################################################################################
+ColorMapF loadColorMapFFromData(const uint8_t* data, size_t length, std::vector<std::string>& errors)
+{
+  if(guessImageFormat(data, tpMin(length, size_t(16)), std::string()) == FileType::pfm)
+    return loadPFMFromData(data, length, errors);
+
   ColorMapF result;
 
   size_t headerSize = sizeof(uint32_t)*2; // Width & Height
-  if(data.size() < headerSize)
+  if(length < headerSize)
   {
-    errors.push_back("Data smaller than expected header, data size: " + std::to_string(data.size()) + " expected: " + std::to_string(headerSize));
+    errors.push_back("Data smaller than expected header, data size: " + std::to_string(length) + " expected: " + std::to_string(headerSize));
     return result;
   }
 
-  const char* src = data.data();
+  const uint8_t* src = data;
 
   uint32_t size[2];
   std::memcpy(size, src, headerSize);
@@ -194,9 +536,9 @@ ColorMapF loadColorMapFFromData(const std::string& data, std::vector<std::string
   size_t   dataSize = (size[0]*size[1]) * 4 * sizeof(float); // Data
   size_t totalSize  = headerSize + dataSize;
 
-  if(data.size() != totalSize)
+  if(length != totalSize)
   {
-    errors.push_back("Size mismatch, data size: " + std::to_string(data.size()) + " expected: " + std::to_string(totalSize));
+    errors.push_back("Size mismatch, data size: " + std::to_string(length) + " expected: " + std::to_string(totalSize));
     return result;
   }
 
@@ -209,25 +551,25 @@ ColorMapF loadColorMapFFromData(const std::string& data, std::vector<std::string
 //##################################################################################################
 std::vector<std::string> imageTypes()
 {
-  return {"*.jpg","*.png","*.bmp","*.jpeg","*.tif","*.tiff","*.tga"};
+  return {"*.jpg","*.png","*.bmp","*.jpeg","*.tif","*.tiff","*.tga","*.qoi","*.ppm","*.pgm","*.pfm"};
 }
 
 //##################################################################################################
 std::unordered_set<std::string> imageTypesSet()
 {
-  return {"*.jpg","*.png","*.bmp","*.jpeg","*.tif","*.tiff","*.tga"};
+  return {"*.jpg","*.png","*.bmp","*.jpeg","*.tif","*.tiff","*.tga","*.qoi","*.ppm","*.pgm","*.pfm"};
 }
 
 //##################################################################################################
 std::string imageTypesFilter()
 {
-  return "*.jpg *.png *.bmp *.jpeg *.tif *.tiff *.tga";
+  return "*.jpg *.png *.bmp *.jpeg *.tif *.tiff *.tga *.qoi *.ppm *.pgm *.pfm";
 }
 
 //##################################################################################################
 std::string imageAndVideoTypesFilter()
 {
-  return "*.jpg *.png *.bmp *.jpeg *.tif *.tiff *.tga *.mp4";
+  return "*.jpg *.png *.bmp *.jpeg *.tif *.tiff *.tga *.qoi *.ppm *.pgm *.pfm *.mp4";
 }
 
 //##################################################################################################
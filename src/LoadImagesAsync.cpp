@@ -0,0 +1,177 @@
+#include "tp_image_utils/LoadImagesAsync.h"
+#include "tp_image_utils/LoadImages.h"
+#include "tp_image_utils/WorkerPool.h"
+
+#include "tp_utils/FileUtils.h"
+#include "tp_utils/DebugUtils.h"
+
+#include <deque>
+#include <memory>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+//! Members are destroyed in reverse order, io tasks queue decode tasks so the io pool must be
+//! drained before the decode pool goes.
+struct Pools
+{
+  WorkerPool decodePool;
+
+  //! File reading is bound by the disk so only needs a couple of threads.
+  WorkerPool ioPool{2};
+};
+
+//##################################################################################################
+Pools& pools()
+{
+  static Pools pools;
+  return pools;
+}
+
+//##################################################################################################
+WorkerPool& ioPool()
+{
+  return pools().ioPool;
+}
+
+//##################################################################################################
+WorkerPool& decodePool()
+{
+  return pools().decodePool;
+}
+
+//##################################################################################################
+void decode(const std::shared_ptr<std::string>& data,
+            const std::function<void(const ColorMap&, const std::vector<std::string>&)>& completed)
+{
+  decodePool().run([=]
+  {
+    std::vector<std::string> errors;
+    ColorMap image = loadImageFromData(*data, errors);
+    completed(image, errors);
+  });
+}
+
+//##################################################################################################
+std::future<ColorMap> toFuture(const std::function<void(const std::function<void(const ColorMap&, const std::vector<std::string>&)>&)>& start)
+{
+  auto promise = std::make_shared<std::promise<ColorMap>>();
+  auto future = promise->get_future();
+  start([promise](const ColorMap& image, const std::vector<std::string>& errors)
+  {
+    for(const auto& error : errors)
+      tpWarning() << error;
+    promise->set_value(image);
+  });
+  return future;
+}
+}
+
+//##################################################################################################
+std::future<ColorMap> loadImageAsync(const std::string& path)
+{
+  return toFuture([&](const auto& completed){loadImageAsync(path, completed);});
+}
+
+//##################################################################################################
+void loadImageAsync(const std::string& path,
+                    const std::function<void(const ColorMap& image, const std::vector<std::string>& errors)>& completed)
+{
+  if(loadImage_ || (!loadImageFromData_ && !loadImageFromRawData_))
+  {
+    // The hook reads the file itself so I/O and decode can't be separated.
+    decodePool().run([=]
+    {
+      std::vector<std::string> errors;
+      ColorMap image = loadImage(path, errors);
+      completed(image, errors);
+    });
+    return;
+  }
+
+  ioPool().run([=]
+  {
+    decode(std::make_shared<std::string>(tp_utils::readBinaryFile(path)), completed);
+  });
+}
+
+//##################################################################################################
+std::future<ColorMap> loadImageFromDataAsync(const std::string& data)
+{
+  auto d = std::make_shared<std::string>(data);
+  return toFuture([&](const auto& completed){decode(d, completed);});
+}
+
+//##################################################################################################
+struct PrefetchImageLoader::Private
+{
+  std::vector<std::string> paths;
+  size_t lookAhead;
+  size_t nextToQueue{0};
+  size_t nextToReturn{0};
+  std::deque<std::future<ColorMap>> pending;
+
+  //################################################################################################
+  Private(const std::vector<std::string>& paths_, size_t lookAhead_):
+    paths(paths_),
+    lookAhead(tpMax(size_t(1), lookAhead_))
+  {
+
+  }
+
+  //################################################################################################
+  void fill()
+  {
+    while(pending.size()<lookAhead && nextToQueue<paths.size())
+    {
+      pending.push_back(loadImageAsync(paths.at(nextToQueue)));
+      nextToQueue++;
+    }
+  }
+};
+
+//##################################################################################################
+PrefetchImageLoader::PrefetchImageLoader(const std::vector<std::string>& paths, size_t lookAhead):
+  d(new Private(paths, lookAhead))
+{
+  d->fill();
+}
+
+//##################################################################################################
+PrefetchImageLoader::~PrefetchImageLoader()
+{
+  for(auto& future : d->pending)
+    future.wait();
+
+  delete d;
+}
+
+//##################################################################################################
+bool PrefetchImageLoader::atEnd() const
+{
+  return d->nextToReturn>=d->paths.size();
+}
+
+//##################################################################################################
+size_t PrefetchImageLoader::index() const
+{
+  return d->nextToReturn;
+}
+
+//##################################################################################################
+ColorMap PrefetchImageLoader::next()
+{
+  if(d->pending.empty())
+    return ColorMap();
+
+  auto future = std::move(d->pending.front());
+  d->pending.pop_front();
+  d->nextToReturn++;
+  d->fill();
+  return future.get();
+}
+
+}
@@ -0,0 +1,32 @@
+#include "tp_image_utils/LoadOptions.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+bool LoadOptions::hasTarget() const
+{
+  return width>0 && height>0;
+}
+
+//##################################################################################################
+size_t LoadOptions::reductionFactor(size_t width, size_t height, size_t maxFactor) const
+{
+  if(!hasTarget() || width<1 || height<1)
+    return 1;
+
+  float fx = float(width ) / float(this->width );
+  float fy = float(height) / float(this->height);
+
+  // Stretch and crop need both dimensions to cover the target, pad only needs one.
+  float limit = (scaleMode==ScaleMode::Pad || scaleMode==ScaleMode::PadCenter)?tpMax(fx, fy):tpMin(fx, fy);
+  limit /= tpMax(minimumFraction, 0.0001f);
+
+  size_t factor=1;
+  while(factor*2<=maxFactor && float(factor*2)<=limit)
+    factor*=2;
+
+  return factor;
+}
+
+}
@@ -0,0 +1,103 @@
+#include "tp_image_utils/MappedFile.h"
+
+#ifdef TP_IMAGE_UTILS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include "tp_utils/FileUtils.h"
+#endif
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct MappedFile::Private
+{
+#ifdef TP_IMAGE_UTILS_MMAP
+  void* mapping{nullptr};
+#else
+  std::string buffer;
+#endif
+  const uint8_t* data{nullptr};
+  size_t size{0};
+};
+
+//##################################################################################################
+MappedFile::MappedFile():
+  d(new Private())
+{
+
+}
+
+//##################################################################################################
+MappedFile::~MappedFile()
+{
+#ifdef TP_IMAGE_UTILS_MMAP
+  if(d->mapping)
+    munmap(d->mapping, d->size);
+#endif
+  delete d;
+}
+
+//##################################################################################################
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path, std::vector<std::string>& errors)
+{
+  std::shared_ptr<MappedFile> file(new MappedFile());
+
+#ifdef TP_IMAGE_UTILS_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd<0)
+  {
+    errors.push_back("Failed to open file: " + path);
+    return nullptr;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st)!=0)
+  {
+    ::close(fd);
+    errors.push_back("Failed to stat file: " + path);
+    return nullptr;
+  }
+
+  file->d->size = size_t(st.st_size);
+  if(file->d->size>0)
+  {
+    void* mapping = mmap(nullptr, file->d->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapping==MAP_FAILED)
+    {
+      ::close(fd);
+      errors.push_back("Failed to map file: " + path);
+      return nullptr;
+    }
+
+    file->d->mapping = mapping;
+    file->d->data = static_cast<const uint8_t*>(mapping);
+  }
+
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+#else
+  file->d->buffer = tp_utils::readBinaryFile(path);
+  file->d->data = reinterpret_cast<const uint8_t*>(file->d->buffer.data());
+  file->d->size = file->d->buffer.size();
+#endif
+
+  return file;
+}
+
+//##################################################################################################
+const uint8_t* MappedFile::data() const
+{
+  return d->data;
+}
+
+//##################################################################################################
+size_t MappedFile::size() const
+{
+  return d->size;
+}
+
+}
@@ -0,0 +1,395 @@
+#include "tp_image_utils/Netpbm.h"
+
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+
+//##################################################################################################
+bool isSpace(uint8_t c)
+{
+  return c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\v' || c=='\f';
+}
+
+//##################################################################################################
+//! Read the next whitespace separated token skipping # comments.
+bool readToken(const uint8_t* data, size_t size, size_t& pos, std::string& token)
+{
+  token.clear();
+  for(;;)
+  {
+    while(pos<size && isSpace(data[pos]))
+      pos++;
+
+    if(pos<size && data[pos]=='#')
+    {
+      while(pos<size && data[pos]!='\n' && data[pos]!='\r')
+        pos++;
+      continue;
+    }
+
+    break;
+  }
+
+  while(pos<size && !isSpace(data[pos]) && token.size()<32)
+    token.push_back(char(data[pos++]));
+
+  return !token.empty();
+}
+
+//##################################################################################################
+bool readUnsigned(const uint8_t* data, size_t size, size_t& pos, size_t& value)
+{
+  std::string token;
+  if(!readToken(data, size, pos, token))
+    return false;
+
+  value=0;
+  for(char c : token)
+  {
+    if(c<'0' || c>'9' || value>100000000)
+      return false;
+    value = value*10 + size_t(c-'0');
+  }
+  return true;
+}
+
+//##################################################################################################
+std::string header(const char* magic, size_t w, size_t h, const char* last)
+{
+  return std::string(magic) + '\n' + std::to_string(w) + ' ' + std::to_string(h) + '\n' + last + '\n';
+}
+
+//##################################################################################################
+bool checkPixelData(const NetpbmHeader& header, size_t size, size_t bytesPerPixel, std::vector<std::string>& errors)
+{
+  if((size-header.dataOffset)/bytesPerPixel/header.width < header.height)
+  {
+    errors.push_back("Netpbm data truncated.");
+    return false;
+  }
+  return true;
+}
+
+//##################################################################################################
+//! Read integer samples from a PGM or PPM and pass each pixel as RGB to write.
+/*!
+Output provides begin(w, h), row(y) and rowComplete(y) in the same way as RowSink.
+*/
+template<typename Pixel, typename Output, typename Write>
+bool decodeInteger(const uint8_t* data, size_t size, Output& output, Write write, std::vector<std::string>& errors)
+{
+  NetpbmHeader header;
+  if(!readNetpbmHeader(data, size, header, errors))
+    return false;
+
+  if(header.type!='5' && header.type!='6')
+  {
+    errors.push_back("Expected a binary PGM or PPM.");
+    return false;
+  }
+
+  size_t channels = (header.type=='6')?3:1;
+  size_t bytesPerSample = (header.maxValue>255)?2:1;
+  if(!checkPixelData(header, size, channels*bytesPerSample, errors))
+    return false;
+
+  size_t w = header.width;
+  size_t h = header.height;
+  if(!output.begin(w, h))
+    return false;
+
+  const uint8_t* s = data + header.dataOffset;
+  uint32_t maxValue = header.maxValue;
+  bool direct = (bytesPerSample==1 && maxValue==255);
+
+  auto sample = [&](size_t c)
+  {
+    uint32_t v = (bytesPerSample==2)?((uint32_t(s[c*2])<<8) | s[c*2+1]):s[c];
+    return uint8_t((tpMin(v, maxValue)*255 + maxValue/2) / maxValue);
+  };
+
+  size_t stride = channels*bytesPerSample;
+  for(size_t y=0; y<h; y++)
+  {
+    Pixel* p = output.row(y);
+    Pixel* pMax = p + w;
+
+    if(direct && channels==1)
+      for(; p<pMax; s++, p++)
+        write(*p, s[0], s[0], s[0]);
+    else if(direct)
+      for(; p<pMax; s+=3, p++)
+        write(*p, s[0], s[1], s[2]);
+    else if(channels==1)
+      for(; p<pMax; s+=stride, p++)
+      {
+        uint8_t v = sample(0);
+        write(*p, v, v, v);
+      }
+    else
+      for(; p<pMax; s+=stride, p++)
+        write(*p, sample(0), sample(1), sample(2));
+
+    if(!output.rowComplete(y))
+      return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+//! Decodes straight into a ByteMap.
+struct ByteMapOutput
+{
+  ByteMap image;
+
+  //################################################################################################
+  bool begin(size_t w, size_t h)
+  {
+    image = ByteMap(w, h);
+    return true;
+  }
+
+  //################################################################################################
+  uint8_t* row(size_t y)
+  {
+    return image.data() + y*image.width();
+  }
+
+  //################################################################################################
+  bool rowComplete(size_t)
+  {
+    return true;
+  }
+};
+
+//##################################################################################################
+void writeRGB(TPPixel& p, uint8_t r, uint8_t g, uint8_t b)
+{
+  p = TPPixel(r, g, b, 255);
+}
+
+//##################################################################################################
+inline float readFloat(const uint8_t* s, bool swap)
+{
+  uint32_t v;
+  std::memcpy(&v, s, 4);
+  if(swap)
+    v = (v>>24) | ((v>>8)&0xFF00) | ((v<<8)&0xFF0000) | (v<<24);
+  float f;
+  std::memcpy(&f, &v, 4);
+  return f;
+}
+
+//##################################################################################################
+bool hostIsLittleEndian()
+{
+  uint16_t v=1;
+  uint8_t b;
+  std::memcpy(&b, &v, 1);
+  return b==1;
+}
+
+}
+
+//##################################################################################################
+bool readNetpbmHeader(const uint8_t* data, size_t size, NetpbmHeader& header, std::vector<std::string>& errors)
+{
+  if(size<3 || data[0]!='P')
+  {
+    errors.push_back("Not a Netpbm image.");
+    return false;
+  }
+
+  header = NetpbmHeader();
+  header.type = char(data[1]);
+  if(header.type!='5' && header.type!='6' && header.type!='F' && header.type!='f')
+  {
+    errors.push_back("Unsupported Netpbm type: P" + std::string(1, header.type));
+    return false;
+  }
+
+  size_t pos=2;
+  if(!readUnsigned(data, size, pos, header.width) || !readUnsigned(data, size, pos, header.height))
+  {
+    errors.push_back("Failed to read Netpbm size.");
+    return false;
+  }
+
+  if(header.type=='F' || header.type=='f')
+  {
+    std::string token;
+    if(!readToken(data, size, pos, token))
+    {
+      errors.push_back("Failed to read PFM scale.");
+      return false;
+    }
+    header.scale = std::strtof(token.c_str(), nullptr);
+    if(header.scale==0.0f)
+    {
+      errors.push_back("Invalid PFM scale.");
+      return false;
+    }
+  }
+  else
+  {
+    size_t maxValue=0;
+    if(!readUnsigned(data, size, pos, maxValue) || maxValue<1 || maxValue>65535)
+    {
+      errors.push_back("Invalid Netpbm max value.");
+      return false;
+    }
+    header.maxValue = uint32_t(maxValue);
+  }
+
+  // A single whitespace character separates the header from the pixel data.
+  if(pos>=size || !isSpace(data[pos]))
+  {
+    errors.push_back("Netpbm header not terminated.");
+    return false;
+  }
+
+  header.dataOffset = pos+1;
+
+  if(header.width<1 || header.height<1)
+  {
+    errors.push_back("Invalid Netpbm size.");
+    return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+std::string savePGMToData(const ByteMap& image)
+{
+  if(image.width()<1 || image.height()<1)
+    return std::string();
+
+  std::string result = header("P5", image.width(), image.height(), "255");
+  result.append(reinterpret_cast<const char*>(image.constData()), image.width()*image.height());
+  return result;
+}
+
+//##################################################################################################
+std::string savePPMToData(const ColorMap& image)
+{
+  if(image.width()<1 || image.height()<1)
+    return std::string();
+
+  std::string result = header("P6", image.width(), image.height(), "255");
+  size_t offset = result.size();
+  size_t count = image.width()*image.height();
+  result.resize(offset + count*3);
+
+  auto d = reinterpret_cast<uint8_t*>(result.data()+offset);
+  const TPPixel* p = image.constData();
+  for(size_t i=0; i<count; i++, p++, d+=3)
+  {
+    d[0] = p->r;
+    d[1] = p->g;
+    d[2] = p->b;
+  }
+
+  return result;
+}
+
+//##################################################################################################
+std::string savePFMToData(const ColorMapF& image)
+{
+  if(image.width()<1 || image.height()<1)
+    return std::string();
+
+  std::string result = header("PF", image.width(), image.height(), hostIsLittleEndian()?"-1.0":"1.0");
+  size_t offset = result.size();
+  size_t w = image.width();
+  size_t h = image.height();
+  result.resize(offset + w*h*12);
+
+  // PFM stores rows bottom to top.
+  auto d = result.data()+offset;
+  for(size_t y=0; y<h; y++)
+  {
+    const glm::vec4* p = image.constData() + (h-1-y)*w;
+    for(size_t x=0; x<w; x++, p++, d+=12)
+      std::memcpy(d, p, 12);
+  }
+
+  return result;
+}
+
+//##################################################################################################
+ByteMap loadPGMFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  ByteMapOutput output;
+  if(!decodeInteger<uint8_t>(data, size, output, [](uint8_t& p, uint8_t r, uint8_t g, uint8_t b)
+  {
+    p = (r==g && g==b)?r:uint8_t((int(r) + int(g) + int(b))/3);
+  }, errors))
+    return ByteMap();
+
+  return output.image;
+}
+
+//##################################################################################################
+ColorMap loadPPMFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  ColorMapRowSink sink;
+  if(!loadPPMRowsFromData(data, size, sink, errors))
+    return ColorMap();
+
+  return sink.takeImage();
+}
+
+//##################################################################################################
+bool loadPPMRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors)
+{
+  return decodeInteger<TPPixel>(data, size, sink, writeRGB, errors);
+}
+
+//##################################################################################################
+ColorMapF loadPFMFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  NetpbmHeader header;
+  if(!readNetpbmHeader(data, size, header, errors))
+    return ColorMapF();
+
+  if(header.type!='F' && header.type!='f')
+  {
+    errors.push_back("Expected a PFM.");
+    return ColorMapF();
+  }
+
+  size_t channels = (header.type=='F')?3:1;
+  if(!checkPixelData(header, size, channels*4, errors))
+    return ColorMapF();
+
+  bool swap = (header.scale<0.0f) != hostIsLittleEndian();
+  size_t w = header.width;
+  size_t h = header.height;
+
+  ColorMapF image(w, h);
+  const uint8_t* s = data + header.dataOffset;
+  for(size_t y=0; y<h; y++)
+  {
+    glm::vec4* p = image.data() + (h-1-y)*w;
+    for(size_t x=0; x<w; x++, p++, s+=channels*4)
+    {
+      if(channels==3)
+        *p = glm::vec4(readFloat(s, swap), readFloat(s+4, swap), readFloat(s+8, swap), 1.0f);
+      else
+      {
+        float v = readFloat(s, swap);
+        *p = glm::vec4(v, v, v, 1.0f);
+      }
+    }
+  }
+
+  return image;
+}
+
+}
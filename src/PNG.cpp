@@ -0,0 +1,467 @@
+#include "tp_image_utils/PNG.h"
+
+#include "tp_utils/Parallel.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+//! CRC-32 tables for slice-by-8, processing 8 bytes per step.
+struct CRCTables
+{
+  uint32_t t[8][256];
+
+  //################################################################################################
+  CRCTables()
+  {
+    for(uint32_t i=0; i<256; i++)
+    {
+      uint32_t c=i;
+      for(int k=0; k<8; k++)
+        c = (c&1)?(0xEDB88320U ^ (c>>1)):(c>>1);
+      t[0][i] = c;
+    }
+
+    for(size_t k=1; k<8; k++)
+      for(size_t i=0; i<256; i++)
+        t[k][i] = (t[k-1][i]>>8) ^ t[0][t[k-1][i] & 0xFF];
+  }
+};
+
+//##################################################################################################
+uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc=0)
+{
+  static const CRCTables tables;
+  const auto& t = tables.t;
+
+  crc = ~crc;
+  for(; n>=8; n-=8, p+=8)
+  {
+    uint32_t a = crc ^ (uint32_t(p[0]) | (uint32_t(p[1])<<8) | (uint32_t(p[2])<<16) | (uint32_t(p[3])<<24));
+    uint32_t b = uint32_t(p[4]) | (uint32_t(p[5])<<8) | (uint32_t(p[6])<<16) | (uint32_t(p[7])<<24);
+    crc = t[7][a & 0xFF] ^ t[6][(a>>8) & 0xFF] ^ t[5][(a>>16) & 0xFF] ^ t[4][a>>24] ^
+          t[3][b & 0xFF] ^ t[2][(b>>8) & 0xFF] ^ t[1][(b>>16) & 0xFF] ^ t[0][b>>24];
+  }
+
+  for(; n>0; n--, p++)
+    crc = t[0][(crc ^ *p) & 0xFF] ^ (crc>>8);
+
+  return ~crc;
+}
+
+//##################################################################################################
+constexpr uint32_t adlerBase=65521;
+
+//##################################################################################################
+uint32_t adler32(const uint8_t* p, size_t n)
+{
+  uint32_t a=1;
+  uint32_t b=0;
+
+  // 5552 is the largest block that can be summed before the 32 bit sums overflow.
+  while(n>0)
+  {
+    size_t block = tpMin(n, size_t(5552));
+    n-=block;
+    for(; block>=8; block-=8, p+=8)
+    {
+      a+=p[0]; b+=a; a+=p[1]; b+=a; a+=p[2]; b+=a; a+=p[3]; b+=a;
+      a+=p[4]; b+=a; a+=p[5]; b+=a; a+=p[6]; b+=a; a+=p[7]; b+=a;
+    }
+    for(; block>0; block--, p++)
+    {
+      a+=*p;
+      b+=a;
+    }
+    a%=adlerBase;
+    b%=adlerBase;
+  }
+
+  return (b<<16) | a;
+}
+
+//##################################################################################################
+//! The Adler-32 of two concatenated buffers from their individual checksums.
+uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t len2)
+{
+  uint64_t rem  = len2 % adlerBase;
+  uint64_t sum1 = adler1 & 0xFFFF;
+  uint64_t sum2 = (rem * sum1) % adlerBase;
+  sum1 += (adler2 & 0xFFFF) + adlerBase - 1;
+  sum2 += (adler1>>16) + (adler2>>16) + adlerBase - rem;
+  sum1 %= adlerBase;
+  sum2 %= adlerBase;
+  return uint32_t((sum2<<16) | sum1);
+}
+
+//##################################################################################################
+//! Writes bits least significant first as required by deflate.
+class BitWriter
+{
+  std::string& m_out;
+  uint64_t m_bits{0};
+  int m_count{0};
+public:
+  //################################################################################################
+  BitWriter(std::string& out):
+    m_out(out)
+  {
+
+  }
+
+  //################################################################################################
+  void put(uint32_t bits, int n)
+  {
+    m_bits |= uint64_t(bits) << m_count;
+    m_count += n;
+    while(m_count>=8)
+    {
+      m_out.push_back(char(m_bits & 0xFF));
+      m_bits>>=8;
+      m_count-=8;
+    }
+  }
+
+  //################################################################################################
+  void alignToByte()
+  {
+    if(m_count>0)
+      put(0, 8-m_count);
+  }
+};
+
+//##################################################################################################
+//! Huffman codes are packed most significant bit first so they are stored reversed.
+uint32_t reverseBits(uint32_t v, int n)
+{
+  uint32_t r=0;
+  for(int i=0; i<n; i++, v>>=1)
+    r = (r<<1) | (v&1);
+  return r;
+}
+
+//##################################################################################################
+//! The fixed literal/length codes from RFC 1951 3.2.6.
+struct FixedCodes
+{
+  uint16_t code[288];
+  uint8_t length[288];
+
+  //################################################################################################
+  FixedCodes()
+  {
+    for(uint32_t v=0; v<288; v++)
+    {
+      if(v<144)      {length[v]=8; code[v]=uint16_t(reverseBits(0x30  + v,       8));}
+      else if(v<256) {length[v]=9; code[v]=uint16_t(reverseBits(0x190 + v - 144, 9));}
+      else if(v<280) {length[v]=7; code[v]=uint16_t(reverseBits(        v - 256, 7));}
+      else           {length[v]=8; code[v]=uint16_t(reverseBits(0xC0  + v - 280, 8));}
+    }
+  }
+};
+
+//##################################################################################################
+int highestBit(uint32_t v)
+{
+  int r=0;
+  while(v>>=1)
+    r++;
+  return r;
+}
+
+//##################################################################################################
+class FixedHuffmanWriter
+{
+  BitWriter m_writer;
+  const FixedCodes& m_codes;
+public:
+  //################################################################################################
+  FixedHuffmanWriter(std::string& out, const FixedCodes& codes):
+    m_writer(out),
+    m_codes(codes)
+  {
+
+  }
+
+  //################################################################################################
+  void beginBlock(bool final)
+  {
+    m_writer.put(final?1:0, 1);
+    m_writer.put(1, 2);
+  }
+
+  //################################################################################################
+  void literal(uint32_t v)
+  {
+    m_writer.put(m_codes.code[v], m_codes.length[v]);
+  }
+
+  //################################################################################################
+  void match(uint32_t length, uint32_t distance)
+  {
+    if(length==258)
+      literal(285);
+    else if(length<=10)
+      literal(254+length);
+    else
+    {
+      uint32_t l = length-3;
+      int bits = highestBit(l)-2;
+      literal(257 + 4*uint32_t(bits+1) + ((l>>bits) & 3));
+      m_writer.put(l & ((1U<<bits)-1), bits);
+    }
+
+    uint32_t d = distance-1;
+    if(d<4)
+      m_writer.put(reverseBits(d, 5), 5);
+    else
+    {
+      int l = highestBit(d);
+      uint32_t code = 2*uint32_t(l) + ((d>>(l-1)) & 1);
+      m_writer.put(reverseBits(code, 5), 5);
+      m_writer.put(d & ((1U<<(l-1))-1), l-1);
+    }
+  }
+
+  //################################################################################################
+  //! End the block, if it is not the last follow it with an empty stored block to byte align.
+  void endBlock(bool final)
+  {
+    literal(256);
+    if(!final)
+    {
+      m_writer.put(0, 3);
+      m_writer.alignToByte();
+      m_writer.put(0x0000, 16);
+      m_writer.put(0xFFFF, 16);
+    }
+    m_writer.alignToByte();
+  }
+};
+
+//##################################################################################################
+inline uint32_t read32(const uint8_t* p)
+{
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+
+//##################################################################################################
+void deflateFixed(const uint8_t* data, size_t n, size_t bytesPerPixel, bool rleOnly, bool final, std::string& out)
+{
+  static const FixedCodes codes;
+
+  constexpr size_t minMatch=4;
+  constexpr size_t maxMatch=258;
+  constexpr size_t window=32768;
+  constexpr int hashBits=14;
+
+  // Fixed Huffman literals are at most 9 bits.
+  out.reserve(out.size() + (n*9)/8 + 16);
+  FixedHuffmanWriter writer(out, codes);
+  writer.beginBlock(final);
+
+  std::vector<uint32_t> table;
+  if(!rleOnly)
+    table.resize(size_t(1)<<hashBits, 0);
+
+  auto matchLength = [&](size_t i, size_t candidate)
+  {
+    size_t maxLength = tpMin(maxMatch, n-i);
+    size_t length=minMatch;
+    while(length<maxLength && data[candidate+length]==data[i+length])
+      length++;
+    return length;
+  };
+
+  size_t i=0;
+  while(i+minMatch<=n)
+  {
+    uint32_t v = read32(data+i);
+    size_t candidate=0;
+    bool found=false;
+
+    if(rleOnly)
+    {
+      if(i>=bytesPerPixel && read32(data+i-bytesPerPixel)==v)
+      {
+        candidate = i-bytesPerPixel;
+        found = true;
+      }
+    }
+    else
+    {
+      size_t h = (v * 2654435761U) >> (32-hashBits);
+      size_t c = table[h];
+      table[h] = uint32_t(i+1);
+      if(c>0 && (i-(c-1))<=window && read32(data+c-1)==v)
+      {
+        candidate = c-1;
+        found = true;
+      }
+    }
+
+    if(found)
+    {
+      size_t length = matchLength(i, candidate);
+      writer.match(uint32_t(length), uint32_t(i-candidate));
+      i+=length;
+    }
+    else
+    {
+      writer.literal(data[i]);
+      i++;
+    }
+  }
+
+  for(; i<n; i++)
+    writer.literal(data[i]);
+
+  writer.endBlock(final);
+}
+
+//##################################################################################################
+void appendChunk(std::string& out, const char* type, const uint8_t* data, size_t size)
+{
+  uint8_t header[8]
+  {
+    uint8_t(size>>24), uint8_t(size>>16), uint8_t(size>>8), uint8_t(size),
+    uint8_t(type[0]), uint8_t(type[1]), uint8_t(type[2]), uint8_t(type[3])
+  };
+  out.append(reinterpret_cast<const char*>(header), 8);
+  if(size>0)
+    out.append(reinterpret_cast<const char*>(data), size);
+
+  uint32_t crc = crc32(header+4, 4);
+  crc = crc32(data, size, crc);
+  uint8_t tail[4]{uint8_t(crc>>24), uint8_t(crc>>16), uint8_t(crc>>8), uint8_t(crc)};
+  out.append(reinterpret_cast<const char*>(tail), 4);
+}
+
+//##################################################################################################
+std::string savePNG(const uint8_t* pixels, size_t width, size_t height, size_t bytesPerPixel, uint8_t colorType, const PNGOptions& options)
+{
+  if(width<1 || height<1 || width>0x7FFFFFFF || height>0x7FFFFFFF)
+    return std::string();
+
+  size_t stride = width*bytesPerPixel;
+  size_t rowsPerChunk = options.rowsPerChunk;
+  if(rowsPerChunk<1)
+    rowsPerChunk = tpMax(size_t(1), size_t(262144) / (stride+1));
+  size_t nChunks = (height+rowsPerChunk-1) / rowsPerChunk;
+
+  struct Chunk
+  {
+    std::string deflated;
+    uint32_t adler{1};
+    size_t length{0};
+  };
+  std::vector<Chunk> chunks(nChunks);
+
+  std::atomic<size_t> c{0};
+  tp_utils::parallel([&](auto /*locker*/)
+  {
+    std::vector<uint8_t> filtered;
+    for(;;)
+    {
+      size_t const i=c++;
+      if(i>=nChunks)
+        return;
+
+      size_t y0 = i*rowsPerChunk;
+      size_t y1 = tpMin(height, y0+rowsPerChunk);
+
+      filtered.resize((y1-y0)*(stride+1));
+      uint8_t* d = filtered.data();
+      for(size_t y=y0; y<y1; y++)
+      {
+        const uint8_t* row = pixels + y*stride;
+        if(options.filter==PNGFilter::Up)
+        {
+          *(d++) = 2;
+          if(y==0)
+            std::memcpy(d, row, stride);
+          else
+          {
+            const uint8_t* prev = row - stride;
+            for(size_t x=0; x<stride; x++)
+              d[x] = uint8_t(row[x] - prev[x]);
+          }
+        }
+        else
+        {
+          *(d++) = 1;
+          std::memcpy(d, row, bytesPerPixel);
+          for(size_t x=bytesPerPixel; x<stride; x++)
+            d[x] = uint8_t(row[x] - row[x-bytesPerPixel]);
+        }
+        d+=stride;
+      }
+
+      auto& chunk = chunks[i];
+      chunk.length = filtered.size();
+      chunk.adler = adler32(filtered.data(), filtered.size());
+      deflateFixed(filtered.data(), filtered.size(), bytesPerPixel, options.rleOnly, i+1==nChunks, chunk.deflated);
+    }
+  });
+
+  std::string out;
+  size_t total=0;
+  for(const auto& chunk : chunks)
+    total += chunk.deflated.size() + 12;
+  out.reserve(total + 64);
+
+  out.append("\x89PNG\r\n\x1A\n", 8);
+
+  uint8_t ihdr[13]
+  {
+    uint8_t(width>>24), uint8_t(width>>16), uint8_t(width>>8), uint8_t(width),
+    uint8_t(height>>24), uint8_t(height>>16), uint8_t(height>>8), uint8_t(height),
+    8, colorType, 0, 0, 0
+  };
+  appendChunk(out, "IHDR", ihdr, 13);
+
+  // Each chunk is written as its own IDAT, the zlib header goes in the first and the Adler-32 in the last.
+  uint32_t adler=1;
+  for(size_t i=0; i<nChunks; i++)
+  {
+    auto& chunk = chunks[i];
+    adler = (i==0)?chunk.adler:adler32Combine(adler, chunk.adler, chunk.length);
+
+    if(i==0)
+      chunk.deflated.insert(0, "\x78\x01", 2);
+
+    if(i+1==nChunks)
+    {
+      uint8_t a[4]{uint8_t(adler>>24), uint8_t(adler>>16), uint8_t(adler>>8), uint8_t(adler)};
+      chunk.deflated.append(reinterpret_cast<const char*>(a), 4);
+    }
+
+    appendChunk(out, "IDAT", reinterpret_cast<const uint8_t*>(chunk.deflated.data()), chunk.deflated.size());
+    std::string().swap(chunk.deflated);
+  }
+
+  appendChunk(out, "IEND", nullptr, 0);
+  return out;
+}
+}
+
+//##################################################################################################
+std::string savePNGToData(const ColorMap& image, const PNGOptions& options)
+{
+  return savePNG(reinterpret_cast<const uint8_t*>(image.constData()), image.width(), image.height(), 4, 6, options);
+}
+
+//##################################################################################################
+std::string savePNGToData(const ByteMap& image, const PNGOptions& options)
+{
+  return savePNG(image.constData(), image.width(), image.height(), 1, 0, options);
+}
+
+}
@@ -0,0 +1,209 @@
+#include "tp_image_utils/PerceptualHash.h"
+#include "tp_image_utils/LoadImages.h"
+#include "tp_image_utils/Scale.h"
+#include "tp_image_utils/ToGray.h"
+
+#include "tp_utils/Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <mutex>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t dctSize=32;
+constexpr size_t hashSize=8;
+
+//##################################################################################################
+ByteMap reduce(const ColorMap& image, size_t width, size_t height)
+{
+  if(image.width()==width && image.height()==height)
+    return toGray(image);
+
+  return toGray(scale(image, width, height));
+}
+
+//##################################################################################################
+uint64_t averageHash(const ColorMap& image)
+{
+  ByteMap gray = reduce(image, hashSize, hashSize);
+  const uint8_t* p = gray.constData();
+
+  size_t sum=0;
+  for(size_t i=0; i<hashSize*hashSize; i++)
+    sum += p[i];
+
+  // Compare scaled values so that the mean doesn't need to be rounded.
+  uint64_t hash=0;
+  for(size_t i=0; i<hashSize*hashSize; i++)
+    if(size_t(p[i])*hashSize*hashSize > sum)
+      hash |= uint64_t(1)<<i;
+
+  return hash;
+}
+
+//##################################################################################################
+uint64_t differenceHash(const ColorMap& image)
+{
+  ByteMap gray = reduce(image, hashSize+1, hashSize);
+  const uint8_t* p = gray.constData();
+
+  uint64_t hash=0;
+  for(size_t y=0; y<hashSize; y++)
+  {
+    const uint8_t* row = p + y*(hashSize+1);
+    for(size_t x=0; x<hashSize; x++)
+      if(row[x+1]>row[x])
+        hash |= uint64_t(1)<<(y*hashSize+x);
+  }
+
+  return hash;
+}
+
+//##################################################################################################
+uint64_t dctHash(const ColorMap& image)
+{
+  // Only frequencies 1 to 8 are needed in each direction. Frequency 0 is skipped so that the DC
+  // term, which is just the mean brightness, does not dominate the median or take a bit.
+  static const auto cosines = []
+  {
+    std::array<float, hashSize*dctSize> c{};
+    for(size_t u=0; u<hashSize; u++)
+      for(size_t x=0; x<dctSize; x++)
+        c[u*dctSize+x] = float(std::cos(double((2*x+1)*(u+1)) * 3.14159265358979323846 / double(2*dctSize)));
+    return c;
+  }();
+
+  ByteMap gray = reduce(image, dctSize, dctSize);
+  const uint8_t* p = gray.constData();
+
+  // Separable DCT-II, first along the rows then down the columns of the result.
+  std::array<float, dctSize*hashSize> rows{};
+  for(size_t y=0; y<dctSize; y++)
+  {
+    for(size_t u=0; u<hashSize; u++)
+    {
+      const float* c = cosines.data() + u*dctSize;
+      float sum=0.0f;
+      for(size_t x=0; x<dctSize; x++)
+        sum += float(p[y*dctSize+x]) * c[x];
+      rows[y*hashSize+u] = sum;
+    }
+  }
+
+  std::array<float, hashSize*hashSize> coefficients{};
+  for(size_t v=0; v<hashSize; v++)
+  {
+    const float* c = cosines.data() + v*dctSize;
+    for(size_t u=0; u<hashSize; u++)
+    {
+      float sum=0.0f;
+      for(size_t y=0; y<dctSize; y++)
+        sum += rows[y*hashSize+u] * c[y];
+      coefficients[v*hashSize+u] = sum;
+    }
+  }
+
+  auto sorted = coefficients;
+  auto middle = sorted.begin() + sorted.size()/2;
+  std::nth_element(sorted.begin(), middle, sorted.end());
+  float median = (*middle + *std::max_element(sorted.begin(), middle)) * 0.5f;
+
+  uint64_t hash=0;
+  for(size_t i=0; i<hashSize*hashSize; i++)
+    if(coefficients[i]>median)
+      hash |= uint64_t(1)<<i;
+
+  return hash;
+}
+}
+
+//##################################################################################################
+uint64_t perceptualHash(const ColorMap& image, PerceptualHashType type)
+{
+  if(image.size()<1)
+    return 0;
+
+  switch(type)
+  {
+    case PerceptualHashType::Average:    return averageHash(image);
+    case PerceptualHashType::Difference: return differenceHash(image);
+    case PerceptualHashType::DCT:        return dctHash(image);
+  }
+
+  return 0;
+}
+
+//##################################################################################################
+std::vector<uint64_t> perceptualHashes(const std::vector<ColorMap>& images, PerceptualHashType type)
+{
+  std::vector<uint64_t> hashes(images.size(), 0);
+
+  std::atomic<size_t> c{0};
+  tp_utils::parallel([&](auto /*locker*/)
+  {
+    for(;;)
+    {
+      size_t const i=c++;
+
+      if(i>=images.size())
+        return;
+
+      hashes[i] = perceptualHash(images[i], type);
+    }
+  });
+
+  return hashes;
+}
+
+//##################################################################################################
+std::vector<uint64_t> perceptualHashesFromFiles(const std::vector<std::string>& paths,
+                                                PerceptualHashType type,
+                                                std::vector<std::string>& errors)
+{
+  std::vector<uint64_t> hashes(paths.size(), 0);
+
+  LoadOptions options;
+  options.width = dctSize;
+  options.height = dctSize;
+
+  std::mutex mutex;
+  std::atomic<size_t> c{0};
+  tp_utils::parallel([&](auto /*locker*/)
+  {
+    std::vector<std::string> threadErrors;
+
+    for(;;)
+    {
+      size_t const i=c++;
+
+      if(i>=paths.size())
+        break;
+
+      ColorMap image = loadImage(paths[i], options, threadErrors);
+      if(image.size()<1)
+        threadErrors.push_back("Failed to hash image: " + paths[i]);
+      else
+        hashes[i] = perceptualHash(image, type);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    errors.insert(errors.end(), threadErrors.begin(), threadErrors.end());
+  });
+
+  return hashes;
+}
+
+//##################################################################################################
+int hammingDistance(uint64_t a, uint64_t b)
+{
+  return int(std::bitset<64>(a^b).count());
+}
+
+}
@@ -0,0 +1,301 @@
+#include "tp_image_utils/QOI.h"
+
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr uint8_t opIndex = 0x00;
+constexpr uint8_t opDiff  = 0x40;
+constexpr uint8_t opLuma  = 0x80;
+constexpr uint8_t opRun   = 0xC0;
+constexpr uint8_t opRGB   = 0xFE;
+constexpr uint8_t opRGBA  = 0xFF;
+constexpr uint8_t mask2   = 0xC0;
+
+constexpr size_t headerSize = 14;
+constexpr uint8_t padding[8]{0,0,0,0,0,0,0,1};
+
+// Matches the limit in the reference implementation to guard against hostile headers.
+constexpr size_t maxPixels = 400000000;
+
+//##################################################################################################
+inline size_t hash(const TPPixel& p)
+{
+  return (size_t(p.r)*3 + size_t(p.g)*5 + size_t(p.b)*7 + size_t(p.a)*11) % 64;
+}
+
+//##################################################################################################
+inline bool equal(const TPPixel& a, const TPPixel& b)
+{
+  return a.r==b.r && a.g==b.g && a.b==b.b && a.a==b.a;
+}
+
+//##################################################################################################
+inline void write32(uint8_t*& d, uint32_t v)
+{
+  d[0] = uint8_t(v>>24);
+  d[1] = uint8_t(v>>16);
+  d[2] = uint8_t(v>>8);
+  d[3] = uint8_t(v);
+  d+=4;
+}
+
+//##################################################################################################
+inline uint32_t read32(const uint8_t* s)
+{
+  return (uint32_t(s[0])<<24) | (uint32_t(s[1])<<16) | (uint32_t(s[2])<<8) | uint32_t(s[3]);
+}
+}
+
+//##################################################################################################
+std::string saveQOIToData(const ColorMap& image)
+{
+  size_t count = image.size();
+  if(count<1 || count>maxPixels)
+    return std::string();
+
+  // Worst case every pixel is a 5 byte RGBA op.
+  std::string result;
+  result.resize(headerSize + count*5 + sizeof(padding));
+
+  auto start = reinterpret_cast<uint8_t*>(result.data());
+  uint8_t* d = start;
+
+  std::memcpy(d, "qoif", 4); d+=4;
+  write32(d, uint32_t(image.width()));
+  write32(d, uint32_t(image.height()));
+  *(d++) = 4; // RGBA
+  *(d++) = 0; // sRGB with linear alpha
+
+  TPPixel index[64];
+  std::fill(index, index+64, TPPixel(0, 0, 0, 0));
+
+  TPPixel prev(0, 0, 0, 255);
+  size_t run=0;
+
+  const TPPixel* s = image.constData();
+  const TPPixel* sMax = s + count;
+  for(; s<sMax; s++)
+  {
+    const TPPixel& p = *s;
+
+    if(equal(p, prev))
+    {
+      run++;
+      if(run==62 || s+1==sMax)
+      {
+        *(d++) = uint8_t(opRun | (run-1));
+        run=0;
+      }
+      continue;
+    }
+
+    if(run>0)
+    {
+      *(d++) = uint8_t(opRun | (run-1));
+      run=0;
+    }
+
+    size_t h = hash(p);
+    if(equal(index[h], p))
+    {
+      *(d++) = uint8_t(opIndex | h);
+    }
+    else
+    {
+      index[h] = p;
+
+      if(p.a == prev.a)
+      {
+        auto vr = int8_t(p.r - prev.r);
+        auto vg = int8_t(p.g - prev.g);
+        auto vb = int8_t(p.b - prev.b);
+        auto vgr = int8_t(vr - vg);
+        auto vgb = int8_t(vb - vg);
+
+        if(vr>-3 && vr<2 && vg>-3 && vg<2 && vb>-3 && vb<2)
+        {
+          *(d++) = uint8_t(opDiff | ((vr+2)<<4) | ((vg+2)<<2) | (vb+2));
+        }
+        else if(vgr>-9 && vgr<8 && vg>-33 && vg<32 && vgb>-9 && vgb<8)
+        {
+          *(d++) = uint8_t(opLuma | (vg+32));
+          *(d++) = uint8_t(((vgr+8)<<4) | (vgb+8));
+        }
+        else
+        {
+          *(d++) = opRGB;
+          *(d++) = p.r;
+          *(d++) = p.g;
+          *(d++) = p.b;
+        }
+      }
+      else
+      {
+        *(d++) = opRGBA;
+        *(d++) = p.r;
+        *(d++) = p.g;
+        *(d++) = p.b;
+        *(d++) = p.a;
+      }
+    }
+
+    prev = p;
+  }
+
+  std::memcpy(d, padding, sizeof(padding));
+  d+=sizeof(padding);
+
+  result.resize(size_t(d-start));
+  return result;
+}
+
+//##################################################################################################
+bool loadQOIRowsFromData(const uint8_t* data, size_t size, RowSink& sink, std::vector<std::string>& errors)
+{
+  if(size<headerSize+sizeof(padding) || std::memcmp(data, "qoif", 4)!=0)
+  {
+    errors.push_back("Not a QOI image.");
+    return false;
+  }
+
+  size_t w = read32(data+4);
+  size_t h = read32(data+8);
+  uint8_t channels = data[12];
+
+  if(w<1 || h<1 || (channels!=3 && channels!=4) || h>=maxPixels/w)
+  {
+    errors.push_back("Invalid QOI header, w: " + std::to_string(w) + " h: " + std::to_string(h) + " channels: " + std::to_string(channels));
+    return false;
+  }
+
+  if(!sink.begin(w, h))
+    return false;
+
+  TPPixel index[64];
+  std::fill(index, index+64, TPPixel(0, 0, 0, 0));
+
+  TPPixel p(0, 0, 0, 255);
+
+  const uint8_t* s = data + headerSize;
+  const uint8_t* sMax = data + size - sizeof(padding);
+
+  // Runs can continue from one row into the next.
+  size_t run=0;
+  bool truncated=false;
+
+  for(size_t y=0; y<h; y++)
+  {
+    TPPixel* d = sink.row(y);
+    TPPixel* dMax = d + w;
+    while(d<dMax)
+    {
+      if(run>0)
+      {
+        size_t n = tpMin(run, size_t(dMax-d));
+        std::fill(d, d+n, p);
+        d+=n;
+        run-=n;
+        continue;
+      }
+
+      if(s>=sMax)
+        truncated=true;
+
+      if(truncated)
+      {
+        // Fill the rest of the image with the last pixel so sinks always see whole rows.
+        std::fill(d, dMax, p);
+        break;
+      }
+
+      uint8_t b1 = *(s++);
+
+      if(b1==opRGB)
+      {
+        if(sMax-s<3)
+        {
+          truncated=true;
+          continue;
+        }
+        p.r = s[0];
+        p.g = s[1];
+        p.b = s[2];
+        s+=3;
+      }
+      else if(b1==opRGBA)
+      {
+        if(sMax-s<4)
+        {
+          truncated=true;
+          continue;
+        }
+        p.r = s[0];
+        p.g = s[1];
+        p.b = s[2];
+        p.a = s[3];
+        s+=4;
+      }
+      else if((b1 & mask2)==opIndex)
+      {
+        p = index[b1];
+      }
+      else if((b1 & mask2)==opDiff)
+      {
+        p.r = uint8_t(p.r + ((b1>>4) & 0x03) - 2);
+        p.g = uint8_t(p.g + ((b1>>2) & 0x03) - 2);
+        p.b = uint8_t(p.b + ( b1     & 0x03) - 2);
+      }
+      else if((b1 & mask2)==opLuma)
+      {
+        if(s>=sMax)
+        {
+          truncated=true;
+          continue;
+        }
+        uint8_t b2 = *(s++);
+        int vg = (b1 & 0x3F) - 32;
+        p.r = uint8_t(p.r + vg - 8 + ((b2>>4) & 0x0F));
+        p.g = uint8_t(p.g + vg);
+        p.b = uint8_t(p.b + vg - 8 +  (b2     & 0x0F));
+      }
+      else
+      {
+        // A run repeats the previous pixel.
+        index[hash(p)] = p;
+        run = size_t(b1 & 0x3F) + 1;
+        continue;
+      }
+
+      index[hash(p)] = p;
+      *(d++) = p;
+    }
+
+    if(!sink.rowComplete(y))
+      return false;
+  }
+
+  if(truncated)
+    errors.push_back("QOI data truncated.");
+
+  return true;
+}
+
+//##################################################################################################
+ColorMap loadQOIFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  ColorMapRowSink sink;
+  loadQOIRowsFromData(data, size, sink, errors);
+  return sink.takeImage();
+}
+
+//##################################################################################################
+ColorMap loadQOIFromData(const std::string& data, std::vector<std::string>& errors)
+{
+  return loadQOIFromData(reinterpret_cast<const uint8_t*>(data.data()), data.size(), errors);
+}
+
+}
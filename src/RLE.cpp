@@ -0,0 +1,328 @@
+#include "tp_image_utils/RLE.h"
+
+#include "tp_utils/JSONUtils.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  define TP_IMAGE_UTILS_RLE_SSE2
+#  include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+namespace tp_image_utils
+{
+
+namespace
+{
+
+#ifdef TP_IMAGE_UTILS_RLE_SSE2
+//##################################################################################################
+inline size_t countTrailingZeros(uint32_t v)
+{
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward(&i, v);
+  return size_t(i);
+#else
+  return size_t(__builtin_ctz(v));
+#endif
+}
+#endif
+
+//##################################################################################################
+//! Returns the number of values from the start of data that are equal to value.
+size_t runLength(const uint8_t* data, size_t size, uint8_t value)
+{
+  size_t i=0;
+
+#ifdef TP_IMAGE_UTILS_RLE_SSE2
+  __m128i v = _mm_set1_epi8(char(value));
+  for(; i+16<=size; i+=16)
+  {
+    uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+i)), v)));
+    if(mask!=0xFFFF)
+      return i + countTrailingZeros(~mask);
+  }
+#endif
+
+  while(i<size && data[i]==value)
+    i++;
+  return i;
+}
+
+//##################################################################################################
+size_t runLength(const uint32_t* data, size_t size, uint32_t value)
+{
+  size_t i=0;
+
+#ifdef TP_IMAGE_UTILS_RLE_SSE2
+  __m128i v = _mm_set1_epi32(int32_t(value));
+  for(; i+4<=size; i+=4)
+  {
+    uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+i)), v)));
+    if(mask!=0xFFFF)
+      return i + countTrailingZeros(~mask)/4;
+  }
+#endif
+
+  while(i<size && data[i]==value)
+    i++;
+  return i;
+}
+
+//##################################################################################################
+//! The COCO compressed RLE string, 5 bits per character with each value stored as a delta from
+//! the value two before it, the quirky i>2 matches the COCO API.
+std::string encodeCounts(const std::vector<int64_t>& counts)
+{
+  std::string result;
+  result.reserve(counts.size()*2);
+
+  for(size_t i=0; i<counts.size(); i++)
+  {
+    int64_t x = counts.at(i);
+    if(i>2)
+      x -= counts.at(i-2);
+
+    for(bool more=true; more;)
+    {
+      int64_t c = x & 0x1F;
+      x >>= 5;
+      more = (c & 0x10)?(x!=-1):(x!=0);
+      if(more)
+        c |= 0x20;
+      result.push_back(char(c+48));
+    }
+  }
+
+  return result;
+}
+
+//##################################################################################################
+//! Parses a COCO compressed RLE string one value at a time.
+class CountsReader
+{
+  const std::string& m_string;
+  size_t m_pos{0};
+  size_t m_index{0};
+  int64_t m_previous[2]{0, 0};
+public:
+  //################################################################################################
+  CountsReader(const std::string& string):
+    m_string(string)
+  {
+
+  }
+
+  //################################################################################################
+  bool atEnd() const
+  {
+    return m_pos>=m_string.size();
+  }
+
+  //################################################################################################
+  bool next(int64_t& value)
+  {
+    int64_t x=0;
+    size_t k=0;
+    for(bool more=true; more; k++)
+    {
+      if(m_pos>=m_string.size() || k>11)
+        return false;
+
+      int64_t c = int64_t(uint8_t(m_string[m_pos++])) - 48;
+      if(c<0 || c>0x3F)
+        return false;
+
+      x |= (c & 0x1F) << (5*k);
+      more = c & 0x20;
+      if(!more && (c & 0x10))
+        x |= int64_t(-1) * (int64_t(1) << (5*(k+1)));
+    }
+
+    if(m_index>2)
+      x += m_previous[m_index%2];
+
+    m_previous[m_index%2] = x;
+    m_index++;
+    value = x;
+    return true;
+  }
+};
+
+//##################################################################################################
+template<typename T>
+nlohmann::json saveRLEJson(const T* data, size_t w, size_t h)
+{
+  nlohmann::json j;
+  j["w"] = w;
+  j["h"] = h;
+
+  std::vector<int64_t> counts;
+  std::vector<int64_t> values;
+
+  size_t size = w*h;
+  for(size_t i=0; i<size;)
+  {
+    size_t length = runLength(data+i, size-i, data[i]);
+    counts.push_back(int64_t(length));
+    values.push_back(int64_t(data[i]));
+    i+=length;
+  }
+
+  // Masks alternate between two values, so only store the pair.
+  bool alternating=true;
+  for(size_t i=2; i<values.size() && alternating; i++)
+    alternating = values.at(i)==values.at(i-2);
+
+  nlohmann::json rle;
+  rle["counts"] = encodeCounts(counts);
+  if(alternating)
+    rle["palette"] = std::vector<int64_t>(values.begin(), values.begin()+int64_t(tpMin(values.size(), size_t(2))));
+  else
+    rle["values"] = encodeCounts(values);
+
+  j["rle"] = std::move(rle);
+  return j;
+}
+
+//##################################################################################################
+template<typename Image, typename T>
+Image loadRLEJson(const nlohmann::json& j, T maxValue, std::vector<std::string>& errors)
+{
+  auto w = TPJSONSizeT(j, "w");
+  auto h = TPJSONSizeT(j, "h");
+
+  auto rle = j.find("rle");
+  if(rle==j.end() || !rle->is_object())
+  {
+    errors.push_back("RLE data missing.");
+    return Image();
+  }
+
+  auto counts = rle->find("counts");
+  if(counts==rle->end() || !counts->is_string())
+  {
+    errors.push_back("RLE counts missing.");
+    return Image();
+  }
+
+  std::vector<T> palette;
+  auto values = rle->find("values");
+  bool hasValues = values!=rle->end() && values->is_string();
+  if(!hasValues)
+  {
+    if(auto p = rle->find("palette"); p!=rle->end() && p->is_array())
+    {
+      for(const auto& v : *p)
+      {
+        if(!v.is_number_integer() || v.template get<int64_t>()<0 || v.template get<uint64_t>()>uint64_t(maxValue))
+        {
+          errors.push_back("Invalid RLE palette.");
+          return Image();
+        }
+        palette.push_back(v.template get<T>());
+      }
+    }
+
+    if(palette.empty() && !counts->template get_ref<const std::string&>().empty())
+    {
+      errors.push_back("RLE values missing.");
+      return Image();
+    }
+  }
+
+  if(h>0 && w>std::numeric_limits<size_t>::max()/h)
+  {
+    errors.push_back("Invalid RLE size.");
+    return Image();
+  }
+  size_t size = w*h;
+
+  // Check that the counts add up before allocating, so a bad size can't cause a huge allocation.
+  {
+    CountsReader countsReader(counts->template get_ref<const std::string&>());
+    size_t total=0;
+    while(!countsReader.atEnd())
+    {
+      int64_t count=0;
+      if(!countsReader.next(count) || count<0 || size_t(count)>(size-total))
+      {
+        errors.push_back("Invalid RLE counts.");
+        return Image();
+      }
+      total += size_t(count);
+    }
+
+    if(total!=size)
+    {
+      errors.push_back("RLE size mismatch, decoded: " + std::to_string(total) + " expected: " + std::to_string(size));
+      return Image();
+    }
+  }
+
+  CountsReader countsReader(counts->template get_ref<const std::string&>());
+  const std::string emptyValues;
+  CountsReader valuesReader(hasValues?values->template get_ref<const std::string&>():emptyValues);
+
+  Image image(w, h);
+  T* dst = image.data();
+  size_t pos=0;
+  for(size_t i=0; !countsReader.atEnd(); i++)
+  {
+    // Already validated above.
+    int64_t count=0;
+    countsReader.next(count);
+
+    T value;
+    if(hasValues)
+    {
+      int64_t v=0;
+      if(!valuesReader.next(v) || v<0 || uint64_t(v)>uint64_t(maxValue))
+      {
+        errors.push_back("Invalid RLE values.");
+        return Image();
+      }
+      value = T(v);
+    }
+    else
+      value = palette.at(i%palette.size());
+
+    std::fill_n(dst+pos, size_t(count), value);
+    pos += size_t(count);
+  }
+
+  return image;
+}
+}
+
+//##################################################################################################
+nlohmann::json saveByteMapToRLEJson(const ByteMap& image)
+{
+  return saveRLEJson(image.constData(), image.width(), image.height());
+}
+
+//##################################################################################################
+nlohmann::json saveIndexMapToRLEJson(const IndexMap& image)
+{
+  return saveRLEJson(image.constData(), image.width(), image.height());
+}
+
+//##################################################################################################
+ByteMap loadByteMapFromRLEJson(const nlohmann::json& j, std::vector<std::string>& errors)
+{
+  return loadRLEJson<ByteMap, uint8_t>(j, 255, errors);
+}
+
+//##################################################################################################
+IndexMap loadIndexMapFromRLEJson(const nlohmann::json& j, std::vector<std::string>& errors)
+{
+  return loadRLEJson<IndexMap, uint32_t>(j, 0xFFFFFFFF, errors);
+}
+
+}
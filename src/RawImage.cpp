@@ -0,0 +1,340 @@
+#include "tp_image_utils/RawImage.h"
+#include "tp_image_utils/MappedFile.h"
+
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+// The header is stored little endian, which is the native byte order on all supported platforms.
+//
+// offset  size  field
+// 0       8     magic "TPRAWIMG"
+// 8       4     version
+// 12      4     pixel type, see RawPixelType
+// 16      8     width
+// 24      8     height
+// 32      8     stride, the number of bytes from the start of one row to the next
+// 40      8     payload offset, aligned to payloadAlignment
+// 48      4     fw
+// 52      4     fh
+// 56      8     reserved
+struct Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t pixelType;
+  uint64_t width;
+  uint64_t height;
+  uint64_t stride;
+  uint64_t payloadOffset;
+  float fw;
+  float fh;
+  uint64_t reserved;
+};
+static_assert(sizeof(Header)==64, "The raw image header must be 64 bytes.");
+
+constexpr char magic[8]{'T','P','R','A','W','I','M','G'};
+constexpr uint32_t version=1;
+constexpr size_t payloadAlignment=64;
+
+//##################################################################################################
+template<typename T> struct Traits;
+
+//##################################################################################################
+template<> struct Traits<ColorMap>
+{
+  using Pixel = TPPixel;
+  static constexpr RawPixelType type = RawPixelType::RGBA8;
+  static float fw(const ColorMap& image){return image.fw();}
+  static float fh(const ColorMap& image){return image.fh();}
+};
+
+//##################################################################################################
+template<> struct Traits<ColorMapF>
+{
+  using Pixel = glm::vec4;
+  static constexpr RawPixelType type = RawPixelType::RGBA32F;
+  static float fw(const ColorMapF& image){return image.fw();}
+  static float fh(const ColorMapF& image){return image.fh();}
+};
+
+//##################################################################################################
+template<> struct Traits<ByteMap>
+{
+  using Pixel = uint8_t;
+  static constexpr RawPixelType type = RawPixelType::Gray8;
+  static float fw(const ByteMap&){return 1.0f;}
+  static float fh(const ByteMap&){return 1.0f;}
+};
+
+//##################################################################################################
+template<> struct Traits<IndexMap>
+{
+  using Pixel = uint32_t;
+  static constexpr RawPixelType type = RawPixelType::Index32;
+  static float fw(const IndexMap&){return 1.0f;}
+  static float fh(const IndexMap&){return 1.0f;}
+};
+
+//##################################################################################################
+template<typename Image>
+Header makeHeader(const Image& image)
+{
+  Header header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.pixelType = uint32_t(Traits<Image>::type);
+  header.width = image.width();
+  header.height = image.height();
+  header.stride = image.width() * sizeof(typename Traits<Image>::Pixel);
+  header.payloadOffset = payloadAlignment;
+  header.fw = Traits<Image>::fw(image);
+  header.fh = Traits<Image>::fh(image);
+  return header;
+}
+
+//##################################################################################################
+template<typename Image>
+std::string saveToData(const Image& image)
+{
+  Header header = makeHeader(image);
+  size_t payloadSize = header.stride * header.height;
+
+  std::string data;
+  data.resize(header.payloadOffset + payloadSize);
+  std::memcpy(data.data(), &header, sizeof(Header));
+  if(payloadSize>0)
+    std::memcpy(data.data()+header.payloadOffset, image.constData(), payloadSize);
+  return data;
+}
+
+//##################################################################################################
+template<typename Image>
+bool saveToFile(const std::string& path, const Image& image)
+{
+  Header header = makeHeader(image);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if(!file)
+    return false;
+
+  char padding[payloadAlignment]{};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  file.write(padding, std::streamsize(header.payloadOffset - sizeof(Header)));
+  file.write(reinterpret_cast<const char*>(image.constData()), std::streamsize(header.stride * header.height));
+  return bool(file);
+}
+
+//##################################################################################################
+template<typename Image>
+bool readHeader(const uint8_t* data, size_t size, Header& header, std::vector<std::string>& errors)
+{
+  using Pixel = typename Traits<Image>::Pixel;
+
+  if(size<sizeof(Header))
+  {
+    errors.push_back("Data smaller than raw image header, data size: " + std::to_string(size));
+    return false;
+  }
+
+  std::memcpy(&header, data, sizeof(Header));
+
+  if(std::memcmp(header.magic, magic, sizeof(magic))!=0)
+  {
+    errors.push_back("Not a raw image.");
+    return false;
+  }
+
+  if(header.version!=version)
+  {
+    errors.push_back("Unsupported raw image version: " + std::to_string(header.version));
+    return false;
+  }
+
+  if(header.pixelType!=uint32_t(Traits<Image>::type))
+  {
+    errors.push_back("Raw image pixel type mismatch, found: " + std::to_string(header.pixelType) + " expected: " + std::to_string(uint32_t(Traits<Image>::type)));
+    return false;
+  }
+
+  // Checked before multiplying so that a hostile header can't wrap the row size to something small.
+  if(header.width<1 || header.height<1 || header.width>(UINT64_MAX - (alignof(Pixel)-1)) / sizeof(Pixel))
+  {
+    errors.push_back("Invalid raw image size.");
+    return false;
+  }
+
+  uint64_t rowSize = header.width * sizeof(Pixel);
+  if(header.stride<1 || header.stride<rowSize || header.payloadOffset<sizeof(Header) || header.payloadOffset % alignof(Pixel) || header.stride % alignof(Pixel))
+  {
+    errors.push_back("Invalid raw image layout.");
+    return false;
+  }
+
+  if(header.payloadOffset>size || header.height>(size-header.payloadOffset) / header.stride)
+  {
+    errors.push_back("Raw image truncated, data size: " + std::to_string(size));
+    return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+template<typename Image>
+Image copyFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  using Pixel = typename Traits<Image>::Pixel;
+
+  Header header;
+  if(!readHeader<Image>(data, size, header, errors))
+    return Image();
+
+  Image image(header.width, header.height);
+
+  const uint8_t* src = data + header.payloadOffset;
+  Pixel* dst = image.data();
+  size_t rowSize = header.width * sizeof(Pixel);
+  for(size_t y=0; y<header.height; y++, src+=header.stride, dst+=header.width)
+    std::memcpy(dst, src, rowSize);
+
+  return image;
+}
+
+//##################################################################################################
+template<typename Image>
+Image wrapFile(const std::string& path, std::vector<std::string>& errors)
+{
+  using Pixel = typename Traits<Image>::Pixel;
+
+  auto file = MappedFile::open(path, errors);
+  if(!file)
+    return Image();
+
+  Header header;
+  if(!readHeader<Image>(file->data(), file->size(), header, errors))
+    return Image();
+
+  // Rows with padding can't be wrapped so fall back to copying.
+  if(header.stride != header.width * sizeof(Pixel))
+    return copyFromData<Image>(file->data(), file->size(), errors);
+
+  auto pixels = reinterpret_cast<const Pixel*>(file->data() + header.payloadOffset);
+  return Image::wrapReadOnly(header.width, header.height, pixels, file, header.fw, header.fh);
+}
+
+//##################################################################################################
+template<typename Image>
+Image copyFile(const std::string& path, std::vector<std::string>& errors)
+{
+  auto file = MappedFile::open(path, errors);
+  if(!file)
+    return Image();
+
+  return copyFromData<Image>(file->data(), file->size(), errors);
+}
+}
+
+//##################################################################################################
+std::string saveRawImageToData(const ColorMap& image)
+{
+  return saveToData(image);
+}
+
+//##################################################################################################
+std::string saveRawImageToData(const ColorMapF& image)
+{
+  return saveToData(image);
+}
+
+//##################################################################################################
+std::string saveRawImageToData(const ByteMap& image)
+{
+  return saveToData(image);
+}
+
+//##################################################################################################
+std::string saveRawImageToData(const IndexMap& image)
+{
+  return saveToData(image);
+}
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const ColorMap& image)
+{
+  return saveToFile(path, image);
+}
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const ColorMapF& image)
+{
+  return saveToFile(path, image);
+}
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const ByteMap& image)
+{
+  return saveToFile(path, image);
+}
+
+//##################################################################################################
+bool saveRawImage(const std::string& path, const IndexMap& image)
+{
+  return saveToFile(path, image);
+}
+
+//##################################################################################################
+ColorMap loadRawColorMap(const std::string& path, std::vector<std::string>& errors)
+{
+  return wrapFile<ColorMap>(path, errors);
+}
+
+//##################################################################################################
+ColorMapF loadRawColorMapF(const std::string& path, std::vector<std::string>& errors)
+{
+  return wrapFile<ColorMapF>(path, errors);
+}
+
+//##################################################################################################
+ByteMap loadRawByteMap(const std::string& path, std::vector<std::string>& errors)
+{
+  return copyFile<ByteMap>(path, errors);
+}
+
+//##################################################################################################
+IndexMap loadRawIndexMap(const std::string& path, std::vector<std::string>& errors)
+{
+  return copyFile<IndexMap>(path, errors);
+}
+
+//##################################################################################################
+ColorMap loadRawColorMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  return copyFromData<ColorMap>(data, size, errors);
+}
+
+//##################################################################################################
+ColorMapF loadRawColorMapFFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  return copyFromData<ColorMapF>(data, size, errors);
+}
+
+//##################################################################################################
+ByteMap loadRawByteMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  return copyFromData<ByteMap>(data, size, errors);
+}
+
+//##################################################################################################
+IndexMap loadRawIndexMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  return copyFromData<IndexMap>(data, size, errors);
+}
+
+}
@@ -0,0 +1,37 @@
+#include "tp_image_utils/RowSink.h"
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+RowSink::~RowSink()=default;
+
+//##################################################################################################
+bool ColorMapRowSink::begin(size_t width, size_t height)
+{
+  m_image = ColorMap(width, height);
+  m_data = m_image.data();
+  return true;
+}
+
+//##################################################################################################
+TPPixel* ColorMapRowSink::row(size_t y)
+{
+  return m_data + y*m_image.width();
+}
+
+//##################################################################################################
+bool ColorMapRowSink::rowComplete(size_t y)
+{
+  TP_UNUSED(y);
+  return true;
+}
+
+//##################################################################################################
+ColorMap ColorMapRowSink::takeImage()
+{
+  m_data = nullptr;
+  return std::move(m_image);
+}
+
+}
@@ -1,7 +1,13 @@
 #include "tp_image_utils/SaveImages.h"
 #include "tp_image_utils/ColorMap.h"
+#include "tp_image_utils/QOI.h"
+#include "tp_image_utils/PNG.h"
+#include "tp_image_utils/BMP.h"
+#include "tp_image_utils/TGA.h"
+#include "tp_image_utils/Netpbm.h"
+#include "tp_image_utils/Base64.h"
 
-#include "base64.h"
+#include "tp_utils/FileUtils.h"
 
 #include <cstring>
 
@@ -11,6 +17,57 @@ bool (*saveImage_)(const std::string& path, const ColorMap& image) = nullptr;
 std::string (*saveImageToData_)(const ColorMap& image) = nullptr;
 std::string (*saveJPEGToData_)(const tp_image_utils::ColorMap& image, int quality) = nullptr;
 std::string (*saveWebPToData_)(const tp_image_utils::ColorMap& image, int quality) = nullptr;
+bool (*saveJPEGToBuffer_)(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context) = nullptr;
+bool (*saveWebPToBuffer_)(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context) = nullptr;
+
+namespace
+{
+//##################################################################################################
+//! Encode straight into the string held by the json to avoid temporary copies of the pixels.
+nlohmann::json saveBytesToJson(size_t w, size_t h, const uint8_t* data, size_t size, bool binary)
+{
+  nlohmann::json j;
+
+  j["w"] = w;
+  j["h"] = h;
+
+  if(w<1 || h<1)
+    return j;
+
+  if(binary)
+  {
+    j["data"] = nlohmann::json::binary(std::vector<uint8_t>(data, data+size));
+    return j;
+  }
+
+  auto& encoded = (j["data"] = std::string()).get_ref<std::string&>();
+  encoded.resize(base64EncodedSize(size));
+  base64Encode(data, size, encoded.data());
+
+  return j;
+}
+
+//##################################################################################################
+bool saveToBuffer(bool (*toBuffer)(const ColorMap&, int, std::string&, std::unique_ptr<EncoderContext>&),
+                  std::string (*toData)(const ColorMap&, int),
+                  const ColorMap& image,
+                  int quality,
+                  std::string& output,
+                  std::unique_ptr<EncoderContext>& context)
+{
+  if(toBuffer)
+    return toBuffer(image, quality, output, context);
+
+  if(!toData)
+  {
+    output.clear();
+    return false;
+  }
+
+  output = toData(image, quality);
+  return !output.empty();
+}
+}
 
 //##################################################################################################
 bool saveImage(const std::string& path, const ColorMap& image)
@@ -18,13 +75,32 @@ bool saveImage(const std::string& path, const ColorMap& image)
   if(saveImage_)
     return saveImage_(path, image);
 
-  return false;
+  // Without a codec installed use the built in ones, but don't write them to files named as other types.
+  std::string extension = (path.size()>4)?tpToLower(path.substr(path.size()-4)):std::string();
+
+  std::string data;
+  if(extension==".qoi")
+    data = saveQOIToData(image);
+  else if(extension==".png")
+    data = savePNGToData(image);
+  else if(extension==".bmp")
+    data = saveBMPToData(image);
+  else if(extension==".tga")
+    data = saveTGAToData(image);
+  else if(extension==".ppm")
+    data = savePPMToData(image);
+
+  // Encoders return an empty string on failure, don't replace an existing file with that.
+  if(data.empty())
+    return false;
+
+  return tp_utils::writeBinaryFile(path, data);
 }
 
 //##################################################################################################
 std::string saveImageToData(const ColorMap& image)
 {
-  return (saveImageToData_)?saveImageToData_(image):std::string();
+  return (saveImageToData_)?saveImageToData_(image):saveQOIToData(image);
 }
 
 //##################################################################################################
@@ -40,41 +116,30 @@ std::string saveWebPToData(const ColorMap& image, int quality)
 }
 
 //##################################################################################################
-nlohmann::json saveImageToJson(const ColorMap& image)
-{
-  nlohmann::json j;
-
-  size_t w = image.width();
-  size_t h = image.height();
-
-  j["w"] = w;
-  j["h"] = h;
-
-  if(w<1 || h<1)
-    return j;
-
-  j["data"] = base64_encode(reinterpret_cast<const unsigned char*>(image.constData()), image.size()*4);
+EncoderContext::~EncoderContext()=default;
 
-  return j;
+//##################################################################################################
+bool saveJPEGToBuffer(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context)
+{
+  return saveToBuffer(saveJPEGToBuffer_, saveJPEGToData_, image, quality, output, context);
 }
 
 //##################################################################################################
-nlohmann::json saveByteMapToJson(const ByteMap& image)
+bool saveWebPToBuffer(const ColorMap& image, int quality, std::string& output, std::unique_ptr<EncoderContext>& context)
 {
-  nlohmann::json j;
-
-  size_t w = image.width();
-  size_t h = image.height();
-
-  j["w"] = w;
-  j["h"] = h;
-
-  if(w<1 || h<1)
-    return j;
+  return saveToBuffer(saveWebPToBuffer_, saveWebPToData_, image, quality, output, context);
+}
 
-  j["data"] = base64_encode(image.constData(), image.size());
+//##################################################################################################
+nlohmann::json saveImageToJson(const ColorMap& image, bool binary)
+{
+  return saveBytesToJson(image.width(), image.height(), reinterpret_cast<const uint8_t*>(image.constData()), image.size()*4, binary);
+}
 
-  return j;
+//##################################################################################################
+nlohmann::json saveByteMapToJson(const ByteMap& image, bool binary)
+{
+  return saveBytesToJson(image.width(), image.height(), image.constData(), image.size(), binary);
 }
 
 //##################################################################################################
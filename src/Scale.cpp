@@ -62,4 +62,210 @@ void halfScaleInPlace(ColorMap& img)
   img = std::move(newImage);
 }
 
+//##################################################################################################
+struct ScaleRowSink::Private
+{
+  size_t width;
+  size_t height;
+
+  size_t srcWidth{0};
+  size_t srcHeight{0};
+  float fy{1.0f};
+
+  // Horizontal weights for each destination column, normalized so they sum to 1.
+  std::vector<size_t> spanStart;
+  std::vector<size_t> spanOffset;
+  std::vector<float> weights;
+
+  std::vector<TPPixel> srcRow;
+  std::vector<float> horizontal;
+
+  // Destination rows that have received some but not all of their source rows, starting at nextRow.
+  struct Accumulator
+  {
+    std::vector<float> values;
+    float weight{0.0f};
+  };
+  std::vector<Accumulator> active;
+  std::vector<Accumulator> spare;
+  size_t nextRow{0};
+
+  ColorMap result;
+  TPPixel* dst{nullptr};
+
+  //################################################################################################
+  Private(size_t width_, size_t height_):
+    width(width_),
+    height(height_)
+  {
+
+  }
+
+  //################################################################################################
+  void finishRow()
+  {
+    Accumulator& a = active.front();
+    float scale = (a.weight>0.0f)?(1.0f/a.weight):0.0f;
+    TPPixel* d = dst + nextRow*width;
+    const float* v = a.values.data();
+    for(size_t x=0; x<width; x++, d++, v+=4)
+    {
+      d->r = uint8_t(tpBound(0.0f, v[0]*scale + 0.5f, 255.0f));
+      d->g = uint8_t(tpBound(0.0f, v[1]*scale + 0.5f, 255.0f));
+      d->b = uint8_t(tpBound(0.0f, v[2]*scale + 0.5f, 255.0f));
+      d->a = uint8_t(tpBound(0.0f, v[3]*scale + 0.5f, 255.0f));
+    }
+
+    spare.push_back(std::move(a));
+    active.erase(active.begin());
+    nextRow++;
+  }
+};
+
+//##################################################################################################
+ScaleRowSink::ScaleRowSink(size_t width, size_t height):
+  d(new Private(width, height))
+{
+
+}
+
+//##################################################################################################
+ScaleRowSink::~ScaleRowSink()
+{
+  delete d;
+}
+
+//##################################################################################################
+bool ScaleRowSink::begin(size_t width, size_t height)
+{
+  if(width<1 || height<1 || d->width<1 || d->height<1)
+    return false;
+
+  d->srcWidth = width;
+  d->srcHeight = height;
+  d->fy = float(height) / float(d->height);
+  d->srcRow.resize(width);
+  d->horizontal.assign(d->width*4, 0.0f);
+  d->active.clear();
+  d->nextRow = 0;
+  d->result = ColorMap(d->width, d->height);
+  d->dst = d->result.data();
+
+  // Same pixel coverage as scale() in stretch mode.
+  float fx = float(width) / float(d->width);
+  d->spanStart.clear();
+  d->spanOffset.clear();
+  d->weights.clear();
+  float px=0.0f;
+  for(size_t x=0; x<d->width; x++)
+  {
+    float sx = float(x+1) * fx;
+    size_t x1 = size_t(std::floor(px));
+    size_t x2 = tpMin(width, tpMax(x1+1, size_t(std::ceil(sx))));
+
+    d->spanStart.push_back(x1);
+    d->spanOffset.push_back(d->weights.size());
+
+    float total=0.0f;
+    for(size_t i=x1; i<x2; i++)
+      total += scale_func::overlap(px, sx, float(i), float(i+1));
+
+    for(size_t i=x1; i<x2; i++)
+      d->weights.push_back((total>0.0f)?(scale_func::overlap(px, sx, float(i), float(i+1))/total):0.0f);
+
+    px=sx;
+  }
+  d->spanOffset.push_back(d->weights.size());
+
+  return true;
+}
+
+//##################################################################################################
+TPPixel* ScaleRowSink::row(size_t y)
+{
+  TP_UNUSED(y);
+  return d->srcRow.data();
+}
+
+//##################################################################################################
+bool ScaleRowSink::rowComplete(size_t y)
+{
+  // Resample the row horizontally.
+  {
+    float* h = d->horizontal.data();
+    for(size_t x=0; x<d->width; x++, h+=4)
+    {
+      const TPPixel* s = d->srcRow.data() + d->spanStart[x];
+      const float* w = d->weights.data() + d->spanOffset[x];
+      const float* wMax = d->weights.data() + d->spanOffset[x+1];
+      float r=0.0f, g=0.0f, b=0.0f, a=0.0f;
+      for(; w<wMax; w++, s++)
+      {
+        r += (*w) * float(s->r);
+        g += (*w) * float(s->g);
+        b += (*w) * float(s->b);
+        a += (*w) * float(s->a);
+      }
+      h[0]=r;
+      h[1]=g;
+      h[2]=b;
+      h[3]=a;
+    }
+  }
+
+  // Add it to each destination row that it overlaps.
+  float y1 = float(y);
+  float y2 = float(y+1);
+  for(size_t j=d->nextRow; j<d->height; j++)
+  {
+    float top = float(j) * d->fy;
+    if(top>=y2)
+      break;
+
+    float oy = scale_func::overlap(y1, y2, top, float(j+1) * d->fy);
+
+    size_t i = j - d->nextRow;
+    while(d->active.size()<=i)
+    {
+      if(d->spare.empty())
+        d->active.emplace_back();
+      else
+      {
+        d->active.push_back(std::move(d->spare.back()));
+        d->spare.pop_back();
+      }
+      d->active.back().values.assign(d->width*4, 0.0f);
+      d->active.back().weight = 0.0f;
+    }
+
+    if(oy<=0.0f)
+      continue;
+
+    auto& a = d->active[i];
+    a.weight += oy;
+    float* v = a.values.data();
+    const float* h = d->horizontal.data();
+    const float* hMax = h + d->horizontal.size();
+    for(; h<hMax; h++, v++)
+      (*v) += oy * (*h);
+  }
+
+  // Finish the destination rows that no later source row can touch.
+  bool last = (y+1)>=d->srcHeight;
+  while(d->nextRow<d->height && !d->active.empty() && (last || float(d->nextRow+1)*d->fy <= y2))
+    d->finishRow();
+
+  return true;
+}
+
+//##################################################################################################
+ColorMap ScaleRowSink::takeImage()
+{
+  if(d->nextRow<d->height)
+    return ColorMap();
+
+  d->dst = nullptr;
+  return std::move(d->result);
+}
+
 }
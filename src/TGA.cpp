@@ -0,0 +1,325 @@
+#include "tp_image_utils/TGA.h"
+
+#include <cstring>
+
+namespace tp_image_utils
+{
+
+namespace
+{
+constexpr size_t headerSize=18;
+
+//##################################################################################################
+struct Header
+{
+  size_t idLength{0};
+  size_t colorMapBytes{0};
+  uint8_t imageType{0};
+  size_t width{0};
+  size_t height{0};
+  size_t bytesPerPixel{0};
+  bool alpha{false};
+  bool topDown{false};
+  bool rle{false};
+};
+
+//##################################################################################################
+inline uint32_t read16(const uint8_t* s)
+{
+  return uint32_t(s[0]) | (uint32_t(s[1])<<8);
+}
+
+//##################################################################################################
+bool readHeader(const uint8_t* data, size_t size, Header& header, std::vector<std::string>& errors)
+{
+  if(size<headerSize)
+  {
+    errors.push_back("TGA data smaller than header.");
+    return false;
+  }
+
+  header.idLength = data[0];
+  header.imageType = data[2];
+  header.width = read16(data+12);
+  header.height = read16(data+14);
+  header.bytesPerPixel = data[16]/8;
+  header.alpha = (data[17] & 0x0F) != 0;
+  header.topDown = (data[17] & 0x20) != 0;
+  header.rle = header.imageType>=9;
+
+  // Interleaving (descriptor bits 6 and 7) was never used by real files.
+  if(data[1]>1 || (data[17] & 0xC0))
+  {
+    errors.push_back("Invalid TGA header.");
+    return false;
+  }
+
+  // Skip any color map, only true color and grayscale images are supported.
+  if(data[1]==1)
+    header.colorMapBytes = size_t(read16(data+5)) * ((size_t(data[7])+7)/8);
+
+  bool gray = (header.imageType==3 || header.imageType==11);
+  bool color = (header.imageType==2 || header.imageType==10);
+  if(!((gray && header.bytesPerPixel==1) || (color && (header.bytesPerPixel==3 || header.bytesPerPixel==4))))
+  {
+    errors.push_back("Unsupported TGA format, type: " + std::to_string(header.imageType) + " bits: " + std::to_string(data[16]));
+    return false;
+  }
+
+  if(header.width<1 || header.height<1)
+  {
+    errors.push_back("Invalid TGA size.");
+    return false;
+  }
+
+  // Check the size against the data before anything is allocated, an RLE packet is at most 128
+  // pixels from 1+bpp bytes.
+  size_t skip = header.idLength + header.colorMapBytes;
+  size_t remaining = size-headerSize;
+  size_t count = header.width*header.height;
+  if(remaining<skip ||
+     (!header.rle && count>(remaining-skip)/header.bytesPerPixel) ||
+     ( header.rle && count>(remaining-skip)/(1+header.bytesPerPixel)*128))
+  {
+    errors.push_back("TGA data truncated.");
+    return false;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+//! Decode pixels in file order writing them straight into the rows of the result.
+template<typename Pixel, typename Convert>
+bool decode(const uint8_t* data, size_t size, const Header& header, Pixel* pixels, Convert convert, std::vector<std::string>& errors)
+{
+  size_t w = header.width;
+  size_t h = header.height;
+  size_t bpp = header.bytesPerPixel;
+  size_t count = w*h;
+
+  const uint8_t* s = data + headerSize;
+  const uint8_t* sMax = data + size;
+  if(size_t(sMax-s) < header.idLength + header.colorMapBytes)
+  {
+    errors.push_back("TGA data truncated.");
+    return false;
+  }
+  s += header.idLength + header.colorMapBytes;
+
+  size_t x=0;
+  size_t y=0;
+  auto rowFor = [&](size_t y){return pixels + (header.topDown?y:(h-1-y))*w;};
+  Pixel* row = rowFor(0);
+
+  auto emit = [&](const uint8_t* p)
+  {
+    row[x] = convert(p);
+    if(++x==w)
+    {
+      x=0;
+      if(++y<h)
+        row = rowFor(y);
+    }
+  };
+
+  if(!header.rle)
+  {
+    if(size_t(sMax-s)/bpp < count)
+    {
+      errors.push_back("TGA data truncated.");
+      return false;
+    }
+
+    for(size_t i=0; i<count; i++, s+=bpp)
+      emit(s);
+    return true;
+  }
+
+  // Packets may cross scanlines so the position is tracked per pixel.
+  for(size_t n=0; n<count;)
+  {
+    if(s>=sMax)
+    {
+      errors.push_back("TGA data truncated.");
+      return false;
+    }
+
+    uint8_t c = *(s++);
+    size_t length = tpMin(size_t(c & 0x7F) + 1, count-n);
+    size_t needed = (c & 0x80)?bpp:length*bpp;
+    if(size_t(sMax-s) < needed)
+    {
+      errors.push_back("TGA data truncated.");
+      return false;
+    }
+
+    if(c & 0x80)
+    {
+      for(size_t i=0; i<length; i++)
+        emit(s);
+      s+=bpp;
+    }
+    else
+    {
+      for(size_t i=0; i<length; i++, s+=bpp)
+        emit(s);
+    }
+
+    n+=length;
+  }
+
+  return true;
+}
+
+//##################################################################################################
+template<typename Pixel, typename Write>
+std::string encode(const Pixel* pixels, size_t w, size_t h, bool rle, uint8_t imageType, uint8_t bitsPerPixel, uint8_t descriptor, Write write)
+{
+  if(w<1 || h<1 || w>0xFFFF || h>0xFFFF)
+    return std::string();
+
+  size_t bpp = bitsPerPixel/8;
+
+  std::string result;
+  result.reserve(headerSize + w*h*bpp + (rle?(w*h+127)/128:0));
+
+  uint8_t header[headerSize]{};
+  header[2] = uint8_t(rle?imageType+8:imageType);
+  header[12] = uint8_t(w);
+  header[13] = uint8_t(w>>8);
+  header[14] = uint8_t(h);
+  header[15] = uint8_t(h>>8);
+  header[16] = bitsPerPixel;
+  header[17] = descriptor | 0x20; // Top down.
+  result.append(reinterpret_cast<const char*>(header), headerSize);
+
+  uint8_t buffer[4];
+  auto append = [&](const Pixel& p)
+  {
+    write(p, buffer);
+    result.append(reinterpret_cast<const char*>(buffer), bpp);
+  };
+
+  if(!rle)
+  {
+    const Pixel* pMax = pixels + w*h;
+    for(const Pixel* p=pixels; p<pMax; p++)
+      append(*p);
+    return result;
+  }
+
+  auto same = [](const Pixel& a, const Pixel& b){return std::memcmp(&a, &b, sizeof(Pixel))==0;};
+
+  // Packets are kept within a row for compatibility with older readers.
+  for(size_t y=0; y<h; y++)
+  {
+    const Pixel* row = pixels + y*w;
+    size_t x=0;
+    while(x<w)
+    {
+      size_t run=1;
+      while(x+run<w && run<128 && same(row[x+run], row[x]))
+        run++;
+
+      if(run>1)
+      {
+        result.push_back(char(0x80 | (run-1)));
+        append(row[x]);
+        x+=run;
+        continue;
+      }
+
+      size_t raw=1;
+      while(x+raw<w && raw<128 && !(x+raw+1<w && same(row[x+raw], row[x+raw+1])))
+        raw++;
+
+      result.push_back(char(raw-1));
+      for(size_t i=0; i<raw; i++)
+        append(row[x+i]);
+      x+=raw;
+    }
+  }
+
+  return result;
+}
+}
+
+//##################################################################################################
+std::string saveTGAToData(const ColorMap& image, bool rle)
+{
+  return encode(image.constData(), image.width(), image.height(), rle, 2, 32, 8, [](const TPPixel& p, uint8_t* d)
+  {
+    d[0] = p.b;
+    d[1] = p.g;
+    d[2] = p.r;
+    d[3] = p.a;
+  });
+}
+
+//##################################################################################################
+std::string saveTGAToData(const ByteMap& image, bool rle)
+{
+  return encode(image.constData(), image.width(), image.height(), rle, 3, 8, 0, [](uint8_t p, uint8_t* d)
+  {
+    d[0] = p;
+  });
+}
+
+//##################################################################################################
+bool isTGAHeader(const uint8_t* data, size_t size)
+{
+  Header header;
+  std::vector<std::string> errors;
+  return readHeader(data, size, header, errors);
+}
+
+//##################################################################################################
+ColorMap loadTGAFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  Header header;
+  if(!readHeader(data, size, header, errors))
+    return ColorMap();
+
+  ColorMap image(header.width, header.height);
+  bool ok=false;
+  switch(header.bytesPerPixel)
+  {
+    case 1:
+    ok = decode(data, size, header, image.data(), [](const uint8_t* p){return TPPixel(p[0], p[0], p[0], 255);}, errors);
+    break;
+
+    case 3:
+    ok = decode(data, size, header, image.data(), [](const uint8_t* p){return TPPixel(p[2], p[1], p[0], 255);}, errors);
+    break;
+
+    default:
+    {
+      // Treat the 4th byte as padding if the descriptor says there are no alpha bits.
+      uint8_t opaque = header.alpha?0:255;
+      ok = decode(data, size, header, image.data(), [opaque](const uint8_t* p){return TPPixel(p[2], p[1], p[0], p[3] | opaque);}, errors);
+      break;
+    }
+  }
+
+  return ok?image:ColorMap();
+}
+
+//##################################################################################################
+ByteMap loadTGAByteMapFromData(const uint8_t* data, size_t size, std::vector<std::string>& errors)
+{
+  Header header;
+  if(!readHeader(data, size, header, errors))
+    return ByteMap();
+
+  ByteMap image(header.width, header.height);
+  bool ok=false;
+  if(header.bytesPerPixel==1)
+    ok = decode(data, size, header, image.data(), [](const uint8_t* p){return p[0];}, errors);
+  else
+    ok = decode(data, size, header, image.data(), [](const uint8_t* p){return uint8_t((int(p[0]) + int(p[1]) + int(p[2]))/3);}, errors);
+
+  return ok?image:ByteMap();
+}
+
+}
@@ -0,0 +1,362 @@
+#include "tp_image_utils/TemporalStats.h"
+#include "tp_image_utils/AbstractImageSequence.h"
+
+#include "tp_utils/Parallel.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#  define TP_IMAGE_UTILS_TEMPORAL_STATS_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace tp_image_utils
+{
+
+namespace
+{
+//##################################################################################################
+template<typename T>
+void forEachRow(size_t h, const T& closure)
+{
+  std::atomic<size_t> c{0};
+  tp_utils::parallel([&](auto /*locker*/)
+  {
+    for(;;)
+    {
+      size_t const y=c++;
+
+      if(y>=h)
+        return;
+
+      closure(y);
+    }
+  });
+}
+
+//##################################################################################################
+//! Fold n values from in into the running mean, sum of squared differences, min, and max.
+void updateRow(const uint8_t* in, float* mean, float* m2, uint8_t* mn, uint8_t* mx, size_t n, float invN)
+{
+  size_t k=0;
+
+#ifdef TP_IMAGE_UTILS_TEMPORAL_STATS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 inv = _mm_set1_ps(invN);
+  for(; k+16<=n; k+=16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+k));
+
+    __m128i* mnp = reinterpret_cast<__m128i*>(mn+k);
+    __m128i* mxp = reinterpret_cast<__m128i*>(mx+k);
+    _mm_storeu_si128(mnp, _mm_min_epu8(_mm_loadu_si128(mnp), v));
+    _mm_storeu_si128(mxp, _mm_max_epu8(_mm_loadu_si128(mxp), v));
+
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    __m128 x[4] =
+    {
+      _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+      _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+      _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)),
+      _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))
+    };
+
+    for(size_t j=0; j<4; j++)
+    {
+      float* mp = mean+k+j*4;
+      float* sp = m2+k+j*4;
+      __m128 m = _mm_loadu_ps(mp);
+      __m128 delta = _mm_sub_ps(x[j], m);
+      m = _mm_add_ps(m, _mm_mul_ps(delta, inv));
+      _mm_storeu_ps(mp, m);
+      _mm_storeu_ps(sp, _mm_add_ps(_mm_loadu_ps(sp), _mm_mul_ps(delta, _mm_sub_ps(x[j], m))));
+    }
+  }
+#endif
+
+  for(; k<n; k++)
+  {
+    float x = float(in[k]);
+    float delta = x - mean[k];
+    mean[k] += delta * invN;
+    m2[k] += delta * (x - mean[k]);
+    mn[k] = std::min(mn[k], in[k]);
+    mx[k] = std::max(mx[k], in[k]);
+  }
+}
+}
+
+//##################################################################################################
+struct TemporalStats::Private
+{
+  size_t medianBins;
+  size_t shift{0};
+
+  size_t w{0};
+  size_t h{0};
+  size_t c{0};
+  size_t n{0};
+
+  std::vector<float> mean;
+  std::vector<float> m2;
+  std::vector<uint8_t> mn;
+  std::vector<uint8_t> mx;
+
+  // medianBins counts for each value, halved when they could overflow.
+  std::vector<uint16_t> hist;
+  size_t histFrames{0};
+
+  //################################################################################################
+  Private(size_t medianBins_):
+    medianBins(medianBins_)
+  {
+    while(medianBins && (size_t(256)>>shift)>medianBins)
+      shift++;
+  }
+
+  //################################################################################################
+  bool add(const uint8_t* data, size_t width, size_t height, size_t channels, std::vector<std::string>& errors)
+  {
+    if(width<1 || height<1)
+    {
+      errors.emplace_back("TemporalStats: empty frame.");
+      return false;
+    }
+
+    if(n==0)
+    {
+      w = width;
+      h = height;
+      c = channels;
+
+      size_t size = w*h*c;
+      mean.assign(size, 0.0f);
+      m2.assign(size, 0.0f);
+      mn.assign(size, 255);
+      mx.assign(size, 0);
+      if(medianBins)
+        hist.assign(size*medianBins, 0);
+      histFrames = 0;
+    }
+    else if(width!=w || height!=h || channels!=c)
+    {
+      errors.emplace_back("TemporalStats: frame size or type differs from previous frames.");
+      return false;
+    }
+
+    n++;
+    float invN = 1.0f / float(n);
+    size_t rowSize = w*c;
+
+    if(medianBins && histFrames==65535)
+    {
+      forEachRow(h, [&](size_t y)
+      {
+        uint16_t* b = hist.data() + y*rowSize*medianBins;
+        uint16_t* bMax = b + rowSize*medianBins;
+        for(; b<bMax; b++)
+          *b = uint16_t((*b+1)>>1);
+      });
+      histFrames = 32768;
+    }
+    histFrames++;
+
+    forEachRow(h, [&](size_t y)
+    {
+      size_t offset = y*rowSize;
+      const uint8_t* in = data + offset;
+      updateRow(in, mean.data()+offset, m2.data()+offset, mn.data()+offset, mx.data()+offset, rowSize, invN);
+
+      if(medianBins)
+      {
+        uint16_t* b = hist.data() + offset*medianBins;
+        for(size_t k=0; k<rowSize; k++, b+=medianBins)
+          b[in[k]>>shift]++;
+      }
+    });
+
+    return true;
+  }
+
+  //################################################################################################
+  template<typename T, typename V>
+  T result(const V& value, decltype(value(0)) alpha) const
+  {
+    T image(w, h);
+    if(n==0)
+      return image;
+
+    auto out = image.data();
+    forEachRow(h, [&](size_t y)
+    {
+      for(size_t x=0; x<w; x++)
+      {
+        size_t k = (y*w+x)*c;
+        auto& o = out[y*w+x];
+        if(c==4)
+          o = {value(k), value(k+1), value(k+2), value(k+3)};
+        else
+        {
+          auto v = value(k);
+          o = {v, v, v, alpha};
+        }
+      }
+    });
+
+    return image;
+  }
+
+  //################################################################################################
+  float medianValue(size_t k) const
+  {
+    const uint16_t* b = hist.data() + k*medianBins;
+
+    float total=0.0f;
+    for(size_t i=0; i<medianBins; i++)
+      total += float(b[i]);
+
+    float half = total*0.5f;
+    float binWidth = float(size_t(1)<<shift);
+    float cumulative=0.0f;
+    for(size_t i=0; i<medianBins; i++)
+    {
+      float count = float(b[i]);
+      if(count>0.0f && cumulative+count>=half)
+      {
+        float v = float(i)*binWidth - 0.5f + ((half-cumulative)/count)*binWidth;
+        return std::clamp(v, 0.0f, 255.0f) / 255.0f;
+      }
+      cumulative += count;
+    }
+
+    return 0.0f;
+  }
+};
+
+//##################################################################################################
+TemporalStats::TemporalStats(size_t medianBins):
+  d(new Private(std::clamp(medianBins, size_t(0), size_t(256))))
+{
+
+}
+
+//##################################################################################################
+TemporalStats::~TemporalStats()
+{
+  delete d;
+}
+
+//##################################################################################################
+bool TemporalStats::add(const ColorMap& image, std::vector<std::string>& errors)
+{
+  return d->add(reinterpret_cast<const uint8_t*>(image.constData()), image.width(), image.height(), 4, errors);
+}
+
+//##################################################################################################
+bool TemporalStats::add(const ByteMap& image, std::vector<std::string>& errors)
+{
+  return d->add(image.constData(), image.width(), image.height(), 1, errors);
+}
+
+//##################################################################################################
+void TemporalStats::clear()
+{
+  d->n = 0;
+  d->w = 0;
+  d->h = 0;
+  d->c = 0;
+  d->mean = std::vector<float>();
+  d->m2 = std::vector<float>();
+  d->mn = std::vector<uint8_t>();
+  d->mx = std::vector<uint8_t>();
+  d->hist = std::vector<uint16_t>();
+}
+
+//##################################################################################################
+size_t TemporalStats::count() const
+{
+  return d->n;
+}
+
+//##################################################################################################
+size_t TemporalStats::width() const
+{
+  return d->w;
+}
+
+//##################################################################################################
+size_t TemporalStats::height() const
+{
+  return d->h;
+}
+
+//##################################################################################################
+size_t TemporalStats::channels() const
+{
+  return d->c;
+}
+
+//##################################################################################################
+ColorMapF TemporalStats::mean() const
+{
+  return d->result<ColorMapF>([&](size_t k){return d->mean[k] / 255.0f;}, 1.0f);
+}
+
+//##################################################################################################
+ColorMapF TemporalStats::variance() const
+{
+  float scale = 1.0f / (float(tpMax(size_t(1), d->n)) * 255.0f * 255.0f);
+  return d->result<ColorMapF>([&](size_t k){return tpMax(0.0f, d->m2[k]) * scale;}, 0.0f);
+}
+
+//##################################################################################################
+ColorMapF TemporalStats::standardDeviation() const
+{
+  float scale = 1.0f / (float(tpMax(size_t(1), d->n)) * 255.0f * 255.0f);
+  return d->result<ColorMapF>([&](size_t k){return std::sqrt(tpMax(0.0f, d->m2[k]) * scale);}, 0.0f);
+}
+
+//##################################################################################################
+ColorMap TemporalStats::minimum() const
+{
+  return d->result<ColorMap>([&](size_t k){return d->mn[k];}, 255);
+}
+
+//##################################################################################################
+ColorMap TemporalStats::maximum() const
+{
+  return d->result<ColorMap>([&](size_t k){return d->mx[k];}, 255);
+}
+
+//##################################################################################################
+ColorMapF TemporalStats::median() const
+{
+  if(!d->medianBins)
+    return ColorMapF();
+
+  return d->result<ColorMapF>([&](size_t k){return d->medianValue(k);}, 1.0f);
+}
+
+//##################################################################################################
+size_t addFrames(AbstractImageSequence& sequence,
+                 size_t first,
+                 size_t last,
+                 size_t stride,
+                 TemporalStats& stats,
+                 std::vector<std::string>& errors)
+{
+  size_t added=0;
+  sequence.loadImages(first, last, stride, [&](size_t, const ColorMap& image)
+  {
+    if(!stats.add(image, errors))
+      return false;
+    added++;
+    return true;
+  });
+  return added;
+}
+
+}
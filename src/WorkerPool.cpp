@@ -0,0 +1,98 @@
+#include "tp_image_utils/WorkerPool.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace tp_image_utils
+{
+
+//##################################################################################################
+struct WorkerPool::Private
+{
+  std::mutex mutex;
+  std::condition_variable waitCondition;
+  std::condition_variable idleCondition;
+  std::deque<std::function<void()>> tasks;
+  std::vector<std::thread> threads;
+  size_t activeTasks{0};
+  bool finish{false};
+
+  //################################################################################################
+  void exec()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;)
+    {
+      waitCondition.wait(lock, [&]{return finish || !tasks.empty();});
+
+      if(tasks.empty())
+        return;
+
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      activeTasks++;
+
+      lock.unlock();
+      task();
+      lock.lock();
+
+      activeTasks--;
+      if(tasks.empty() && activeTasks==0)
+        idleCondition.notify_all();
+    }
+  }
+};
+
+//##################################################################################################
+WorkerPool::WorkerPool(size_t nThreads):
+  d(new Private())
+{
+  if(nThreads<1)
+    nThreads = tpMax(size_t(1), size_t(std::thread::hardware_concurrency()));
+
+  d->threads.reserve(nThreads);
+  for(size_t i=0; i<nThreads; i++)
+    d->threads.emplace_back([&]{d->exec();});
+}
+
+//##################################################################################################
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->finish = true;
+  }
+  d->waitCondition.notify_all();
+
+  for(auto& thread : d->threads)
+    thread.join();
+
+  delete d;
+}
+
+//##################################################################################################
+size_t WorkerPool::nThreads() const
+{
+  return d->threads.size();
+}
+
+//##################################################################################################
+void WorkerPool::run(const std::function<void()>& task)
+{
+  {
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->tasks.push_back(task);
+  }
+  d->waitCondition.notify_one();
+}
+
+//##################################################################################################
+void WorkerPool::waitForIdle()
+{
+  std::unique_lock<std::mutex> lock(d->mutex);
+  d->idleCondition.wait(lock, [&]{return d->tasks.empty() && d->activeTasks==0;});
+}
+
+}
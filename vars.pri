@@ -53,3 +53,81 @@ HEADERS += inc/tp_image_utils/Scale.h
 
 SOURCES += src/PngInfo.cpp
 HEADERS += inc/tp_image_utils/PngInfo.h
+
+SOURCES += src/WorkerPool.cpp
+HEADERS += inc/tp_image_utils/WorkerPool.h
+
+SOURCES += src/LoadImagesAsync.cpp
+HEADERS += inc/tp_image_utils/LoadImagesAsync.h
+
+SOURCES += src/ImageInfo.cpp
+HEADERS += inc/tp_image_utils/ImageInfo.h
+
+SOURCES += src/ImageCache.cpp
+HEADERS += inc/tp_image_utils/ImageCache.h
+
+SOURCES += src/MappedFile.cpp
+HEADERS += inc/tp_image_utils/MappedFile.h
+
+SOURCES += src/RawImage.cpp
+HEADERS += inc/tp_image_utils/RawImage.h
+
+SOURCES += src/QOI.cpp
+HEADERS += inc/tp_image_utils/QOI.h
+
+SOURCES += src/PNG.cpp
+HEADERS += inc/tp_image_utils/PNG.h
+
+SOURCES += src/BMP.cpp
+HEADERS += inc/tp_image_utils/BMP.h
+
+SOURCES += src/TGA.cpp
+HEADERS += inc/tp_image_utils/TGA.h
+
+SOURCES += src/Netpbm.cpp
+HEADERS += inc/tp_image_utils/Netpbm.h
+
+SOURCES += src/Base64.cpp
+HEADERS += inc/tp_image_utils/Base64.h
+
+SOURCES += src/RLE.cpp
+HEADERS += inc/tp_image_utils/RLE.h
+
+SOURCES += src/RowSink.cpp
+HEADERS += inc/tp_image_utils/RowSink.h
+
+SOURCES += src/LoadOptions.cpp
+HEADERS += inc/tp_image_utils/LoadOptions.h
+
+SOURCES += src/BatchEncoder.cpp
+HEADERS += inc/tp_image_utils/BatchEncoder.h
+
+SOURCES += src/FrameReader.cpp
+HEADERS += inc/tp_image_utils/FrameReader.h
+
+SOURCES += src/ImageDirectorySequence.cpp
+HEADERS += inc/tp_image_utils/ImageDirectorySequence.h
+
+SOURCES += src/TemporalStats.cpp
+HEADERS += inc/tp_image_utils/TemporalStats.h
+
+SOURCES += src/DeltaFrameStore.cpp
+HEADERS += inc/tp_image_utils/DeltaFrameStore.h
+
+SOURCES += src/ImagePaths.cpp
+HEADERS += inc/tp_image_utils/ImagePaths.h
+
+SOURCES += src/Exif.cpp
+HEADERS += inc/tp_image_utils/Exif.h
+
+SOURCES += src/CompressibleColorMap.cpp
+HEADERS += inc/tp_image_utils/CompressibleColorMap.h
+
+SOURCES += src/ContentHash.cpp
+HEADERS += inc/tp_image_utils/ContentHash.h
+
+SOURCES += src/PerceptualHash.cpp
+HEADERS += inc/tp_image_utils/PerceptualHash.h
+
+SOURCES += src/HammingIndex.cpp
+HEADERS += inc/tp_image_utils/HammingIndex.h